@@ -17,7 +17,8 @@ public class ACFClimbing : ModuleRules
 			"AIModule",
 			"StateTreeModule",
 			"GameplayStateTreeModule",
-			"UMG"
+			"UMG",
+			"ReplicationGraph"
 		});
 
 		PrivateDependencyModuleNames.AddRange(new string[] { });
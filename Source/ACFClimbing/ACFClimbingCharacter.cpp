@@ -6,6 +6,7 @@
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "ACFCharacterMovementComponent.h"
+#include "ACFObstacleProbeComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/Controller.h"
 #include "EnhancedInputComponent.h"
@@ -56,6 +57,9 @@ AACFClimbingCharacter::AACFClimbingCharacter(const FObjectInitializer& ObjectIni
 
 	MovementComponent = Cast<UACFCharacterMovementComponent>(GetCharacterMovement());
 
+	// Create the obstacle probe shared by the climbing checks
+	ObstacleProbe = CreateDefaultSubobject<UACFObstacleProbeComponent>(TEXT("ObstacleProbe"));
+
 }
 
 void AACFClimbingCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -64,7 +68,7 @@ void AACFClimbingCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInp
 	if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent)) {
 		
 		// Jumping
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &ACharacter::Jump);
+		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &AACFClimbingCharacter::DoJumpStart);
 		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &ACharacter::StopJumping);
 
 		// Moving
@@ -153,6 +157,13 @@ void AACFClimbingCharacter::DoLook(float Yaw, float Pitch)
 
 void AACFClimbingCharacter::DoJumpStart()
 {
+	// while climbing, jumping climbs up the ledge in front of us if there is one
+	if (MovementComponent->IsClimbing())
+	{
+		MovementComponent->RequestLedgeClimb();
+		return;
+	}
+
 	// signal the character to jump
 	Jump();
 }
@@ -9,6 +9,7 @@
 
 class USpringArmComponent;
 class UCameraComponent;
+class UACFObstacleProbeComponent;
 class UInputAction;
 struct FInputActionValue;
 
@@ -52,6 +53,9 @@ public:
 	UFUNCTION(BlueprintPure)
 	FORCEINLINE UACFCharacterMovementComponent* GetACFMovementComponent() const { return MovementComponent; }
 
+	/** Returns ObstacleProbe subobject **/
+	FORCEINLINE UACFObstacleProbeComponent* GetObstacleProbe() const { return ObstacleProbe; }
+
 protected:
 
 	/** Initialize input action bindings */
@@ -92,6 +96,10 @@ protected:
 	UPROPERTY(Category = Character, VisibleAnywhere, BlueprintReadOnly)
 	TObjectPtr<UACFCharacterMovementComponent> MovementComponent;
 
+	/** Shared forward obstacle probe used by climbing checks */
+	UPROPERTY(Category = Character, VisibleAnywhere, BlueprintReadOnly)
+	TObjectPtr<UACFObstacleProbeComponent> ObstacleProbe;
+
 private:
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -3,10 +3,16 @@
 #include "GameFramework/Character.h"
 #include "Components/CapsuleComponent.h"
 #include "ACFCustomMovementModes.h"
+#include "ACFObstacleProbeComponent.h"
 #include "Net/UnrealNetwork.h"
 
 namespace 
 {
+constexpr float WALL_SWEEP_FORWARD_OFFSET = 20.f;
+
+// About 1 degree. Surface normals within this are treated as the same surface when combining moves
+constexpr float SAME_SURFACE_MIN_DOT = .9998f;
+
 bool IsLocationWalkable(const UWorld* World, const FVector& LocationToCheck, const float WalkableHeight, const FCollisionQueryParams& QueryParams) noexcept 
 {
 
@@ -27,12 +33,120 @@ FHitResult CheckFloor(const UWorld* World, const FVector& Location, float MaxDis
 	World->LineTraceSingleByChannel(Hit, Location, End, ECC_WorldStatic, QueryParams);
 	return Hit;
 }
+
+// Normals are zero while not climbing, which only matches another zero normal
+bool IsSameClimbSurface(const FVector& Normal, const FVector& OtherNormal) noexcept
+{
+	if (Normal.IsZero() || OtherNormal.IsZero()) 
+	{
+		return Normal.IsZero() == OtherNormal.IsZero();
+	}
+
+	return FVector::DotProduct(Normal, OtherNormal) >= SAME_SURFACE_MIN_DOT;
+}
+
+// Low-pass smoothing factor for a first order filter with the given cutoff frequency
+float OneEuroAlpha(const float DeltaTime, const float CutoffHz) noexcept
+{
+	const float Tau = 1.f / (2.f * UE_PI * CutoffHz);
+	return 1.f / (1.f + Tau / DeltaTime);
+}
+}
+
+void FACFCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	ClimbingFlags = static_cast<const FSavedMove_ACFCharacter&>(ClientMove).ClimbingFlags;
+}
+
+bool FACFCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	// Only the used bits go on the wire
+	Ar.SerializeBits(&ClimbingFlags, ACF_CLIMBING_MOVE_FLAG_BITS);
+
+	return !Ar.IsError();
+}
+
+FACFCharacterNetworkMoveDataContainer::FACFCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &ACFMoveData[0];
+	PendingMoveData = &ACFMoveData[1];
+	OldMoveData = &ACFMoveData[2];
+}
+
+void FSavedMove_ACFCharacter::Clear()
+{
+	Super::Clear();
+
+	ClimbingFlags = 0;
+	ClimbSurfaceNormal = FVector::ZeroVector;
+	ClimbingState = FACFClimbingMoveState();
+}
+
+void FSavedMove_ACFCharacter::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	const UACFCharacterMovementComponent* MovementComponent = CastChecked<UACFCharacterMovementComponent>(C->GetCharacterMovement());
+	ClimbingFlags = MovementComponent->GetClimbingMoveFlags();
+	ClimbSurfaceNormal = MovementComponent->GetClimbSurfaceNormal();
+
+	// Taken before the move runs, so a replay starts from the same filter state the move did
+	ClimbingState = MovementComponent->GetClimbingMoveState();
+}
+
+bool FSavedMove_ACFCharacter::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_ACFCharacter* NewACFMove = static_cast<const FSavedMove_ACFCharacter*>(NewMove.Get());
+
+	if (ClimbingFlags != NewACFMove->ClimbingFlags || !IsSameClimbSurface(ClimbSurfaceNormal, NewACFMove->ClimbSurfaceNormal))
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+bool FSavedMove_ACFCharacter::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
+{
+	const FSavedMove_ACFCharacter* LastAckedACFMove = static_cast<const FSavedMove_ACFCharacter*>(LastAckedMove.Get());
+
+	if (ClimbingFlags != LastAckedACFMove->ClimbingFlags)
+	{
+		return true;
+	}
+
+	return Super::IsImportantMove(LastAckedMove);
+}
+
+void FSavedMove_ACFCharacter::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	UACFCharacterMovementComponent* MovementComponent = CastChecked<UACFCharacterMovementComponent>(C->GetCharacterMovement());
+	MovementComponent->SetClimbingMoveFlags(ClimbingFlags);
+	MovementComponent->SetClimbingMoveState(ClimbingState);
+}
+
+FNetworkPredictionData_Client_ACFCharacter::FNetworkPredictionData_Client_ACFCharacter(const UCharacterMovementComponent& ClientMovement)
+	: FNetworkPredictionData_Client_Character(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_ACFCharacter::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_ACFCharacter());
 }
 
 UACFCharacterMovementComponent::UACFCharacterMovementComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 	SetIsReplicatedByDefault(true);
+
+	SetNetworkMoveDataContainer(ACFMoveDataContainer);
 }
 
 void UACFCharacterMovementComponent::BeginPlay()
@@ -41,23 +155,56 @@ void UACFCharacterMovementComponent::BeginPlay()
 	ClimbQueryParams.AddIgnoredActor(GetOwner());
 
 	AnimInstance = GetCharacterOwner()->GetMesh()->GetAnimInstance();
+
+	// Characters without a probe still climb, tracing on their own instead of sharing the probe's results
+	ObstacleProbe = GetOwner()->FindComponentByClass<UACFObstacleProbeComponent>();
+	ensureMsgf(ObstacleProbe, TEXT("%s has no obstacle probe, climbing falls back to its own traces"), *GetNameSafe(GetOwner()));
 }
 
 void UACFCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	// Avoid checking for collisions when not climbing or trying to
-	if (IsClimbing()) 
+	// Climbing sweeps for walls inside each move, so replayed moves sweep from their own position.
+	// Auto grab runs where the input comes from, and reaches the server as a climb request in the next move
+	if (bAutoGrabWhileFalling && IsFalling() && CharacterOwner && CharacterOwner->IsLocallyControlled()) 
 	{
-		SweepAndStoreWallHits();
+		UpdateAutoGrab();
+	}
+	else 
+	{
+		ResetAutoGrab();
 	}
 }
 
-void UACFCharacterMovementComponent::TryClimbing_Implementation() 
+void UACFCharacterMovementComponent::TryClimbing() 
 {
-	SweepAndStoreWallHits();
+	bClimbRequested = true;
+}
+
+void UACFCharacterMovementComponent::CancelClimbing() 
+{
+	bCancelClimbRequested = true;
+}
+
+void UACFCharacterMovementComponent::RequestLedgeClimb() 
+{
+	bLedgeClimbRequested = true;
+}
 
+void UACFCharacterMovementComponent::EvaluateClimbRequest() 
+{
 	const FVector Forward = UpdatedComponent->GetForwardVector();
+
+	// Auto grab hits were already filtered by the async probes, facing check included, so no synchronous trace is needed while falling.
+	// The server has no probe results for remote players and sweeps once here instead
+	if (bWallHitsFromAutoGrab) 
+	{
+		bWantsToClimb = CurrentWallHits.ContainsByPredicate([this, &Forward](const FHitResult& Hit) { return IsWallAngleClimbable(Hit, Forward); });
+		return;
+	}
+
+	SweepAndStoreWallHits();
+
 	auto HitIt = CurrentWallHits.CreateConstIterator();
 	while (!bWantsToClimb && HitIt) 
 	{
@@ -66,11 +213,6 @@ void UACFCharacterMovementComponent::TryClimbing_Implementation()
 	}
 }
 
-void UACFCharacterMovementComponent::CancelClimbing_Implementation() 
-{
-	bWantsToClimb = false;
-}
-
 bool UACFCharacterMovementComponent::IsClimbing() const 
 {
 	return MovementMode == EMovementMode::MOVE_Custom && CustomMovementMode == EACFCustomMovementMode::Climbing;
@@ -78,19 +220,75 @@ bool UACFCharacterMovementComponent::IsClimbing() const
 
 FVector UACFCharacterMovementComponent::GetClimbSurfaceNormal() const 
 {
-	return CurrentClimbingNormal;
+	// Surface info is computed by the server and the predicting client, simulated proxies read the replicated normal
+	return GetOwnerRole() == ROLE_SimulatedProxy ? FVector(ReplicatedClimbingNormal) : CurrentClimbingNormal;
 }
 
 void UACFCharacterMovementComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
-	DOREPLIFETIME(UACFCharacterMovementComponent, CurrentClimbingNormal);
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UACFCharacterMovementComponent, ReplicatedClimbingNormal);
+}
+
+FNetworkPredictionData_Client* UACFCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr) 
+	{
+		UACFCharacterMovementComponent* MutableThis = const_cast<UACFCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_ACFCharacter(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+uint8 UACFCharacterMovementComponent::GetClimbingMoveFlags() const noexcept
+{
+	EACFClimbingMoveFlags Flags = EACFClimbingMoveFlags::None;
+	if (bClimbRequested) 
+	{
+		Flags |= EACFClimbingMoveFlags::RequestClimb;
+	}
+	if (bCancelClimbRequested) 
+	{
+		Flags |= EACFClimbingMoveFlags::CancelClimb;
+	}
+	if (bLedgeClimbRequested) 
+	{
+		Flags |= EACFClimbingMoveFlags::LedgeClimb;
+	}
+	return static_cast<uint8>(Flags);
+}
+
+void UACFCharacterMovementComponent::SetClimbingMoveFlags(const uint8 Flags) noexcept
+{
+	const EACFClimbingMoveFlags MoveFlags = static_cast<EACFClimbingMoveFlags>(Flags);
+	bClimbRequested = EnumHasAnyFlags(MoveFlags, EACFClimbingMoveFlags::RequestClimb);
+	bCancelClimbRequested = EnumHasAnyFlags(MoveFlags, EACFClimbingMoveFlags::CancelClimb);
+	bLedgeClimbRequested = EnumHasAnyFlags(MoveFlags, EACFClimbingMoveFlags::LedgeClimb);
+}
+
+FACFClimbingMoveState UACFCharacterMovementComponent::GetClimbingMoveState() const noexcept
+{
+	FACFClimbingMoveState State;
+	State.NormalFilterState = NormalFilterState;
+	State.PositionFilterState = PositionFilterState;
+	State.bWantsToClimb = bWantsToClimb;
+	return State;
+}
+
+void UACFCharacterMovementComponent::SetClimbingMoveState(const FACFClimbingMoveState& State) noexcept
+{
+	NormalFilterState = State.NormalFilterState;
+	PositionFilterState = State.PositionFilterState;
+	bWantsToClimb = State.bWantsToClimb;
 }
 
 void UACFCharacterMovementComponent::SweepAndStoreWallHits() 
 {
 	const FCollisionShape CollisionShape = FCollisionShape::MakeCapsule(CollisionCapsuleRadius, CollisionCapsuleHalfHeight);
 	
-	const FVector StartOffset = UpdatedComponent->GetForwardVector() * 20.;
+	const FVector StartOffset = UpdatedComponent->GetForwardVector() * WALL_SWEEP_FORWARD_OFFSET;
 
 	// Avoid using the same Start/End location for a Sweep, as it doesn't trigger hits on Landscapes.
 	const FVector Start = UpdatedComponent->GetComponentLocation() + StartOffset;
@@ -113,6 +311,13 @@ void UACFCharacterMovementComponent::SweepAndStoreWallHits()
 }
 
 bool UACFCharacterMovementComponent::IsWallClimbable(const FHitResult& Hit, const FVector& Forward) const noexcept
+{
+	const float VerticalDot = FVector::DotProduct(Hit.Normal, Hit.Normal.GetSafeNormal2D());
+
+	return IsWallAngleClimbable(Hit, Forward) && IsFacingSurface(VerticalDot);	
+}
+
+bool UACFCharacterMovementComponent::IsWallAngleClimbable(const FHitResult& Hit, const FVector& Forward) const noexcept
 {
 	const FVector HorizontalNormal = Hit.Normal.GetSafeNormal2D();
 	
@@ -123,19 +328,128 @@ bool UACFCharacterMovementComponent::IsWallClimbable(const FHitResult& Hit, cons
 	
 	const bool bIsCeiling = FMath::IsNearlyZero(VerticalDot);
 	
-	return HorizontalDegrees <= MinHorizontalDegreesToStartClimbing && !bIsCeiling && IsFacingSurface(VerticalDot);	
+	return HorizontalDegrees <= MinHorizontalDegreesToStartClimbing && !bIsCeiling;
 }
 
-bool UACFCharacterMovementComponent::EyeHeightTrace(const float TraceDistance) const noexcept
+void UACFCharacterMovementComponent::UpdateAutoGrab() 
 {
-	FHitResult UpperEdgeHit;
+	if (bWantsToClimb || bClimbRequested) 
+	{
+		return;
+	}
+
+	ReadAutoGrabProbes();
+
+	// Same reach the Climb input has, so auto grabbing doesn't snap from further away than a manual grab
+	const float GrabReach = CollisionCapsuleRadius + WALL_SWEEP_FORWARD_OFFSET;
+	const float DistanceToWall = FVector::PointPlaneDist(UpdatedComponent->GetComponentLocation(), AutoGrabContactPoint, AutoGrabContactNormal);
+
+	if (bAutoGrabArmed && DistanceToWall <= GrabReach) 
+	{
+		// Same path as the Climb input, so the grab is predicted, saved and replayed on the server.
+		// The move reads the probe hits instead of sweeping again
+		CurrentWallHits = MoveTemp(AutoGrabHits);
+		bWallHitsFromAutoGrab = true;
+		bClimbRequested = true;
+		ResetAutoGrab();
+		return;
+	}
+
+	IssueAutoGrabProbes();
+}
+
+void UACFCharacterMovementComponent::IssueAutoGrabProbes() 
+{
+	// Previous probes still in flight
+	if (AutoGrabWallProbe.IsValid() || AutoGrabEyeProbe.IsValid()) 
+	{
+		return;
+	}
+
+	const float T = AutoGrabLookAheadTime;
+	const FVector Gravity = FVector(0., 0., GetGravityZ());
+	const FVector PredictedLocation = UpdatedComponent->GetComponentLocation() + Velocity * T + .5f * Gravity * T * T;
+	const FVector Forward = UpdatedComponent->GetForwardVector();
+
+	const FCollisionShape CollisionShape = FCollisionShape::MakeCapsule(CollisionCapsuleRadius, CollisionCapsuleHalfHeight);
+	const FVector WallStart = PredictedLocation + Forward * WALL_SWEEP_FORWARD_OFFSET;
+	const FVector WallEnd = WallStart + Forward * AutoGrabProbeDistance;
+
+	AutoGrabWallProbe = GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Multi, WallStart, WallEnd, FQuat::Identity, ECC_WorldStatic, CollisionShape, ClimbQueryParams);
+
+	const FVector EyeStart = PredictedLocation + UpdatedComponent->GetUpVector() * GetCharacterOwner()->BaseEyeHeight;
+	const FVector EyeEnd = EyeStart + Forward * (WALL_SWEEP_FORWARD_OFFSET + AutoGrabProbeDistance);
+
+	AutoGrabEyeProbe = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyeStart, EyeEnd, ECC_WorldStatic, ClimbQueryParams);
 
-	const FVector Start = UpdatedComponent->GetComponentLocation() + (UpdatedComponent->GetUpVector() * GetCharacterOwner()->BaseEyeHeight);
-	const FVector End = Start + (UpdatedComponent->GetForwardVector() * TraceDistance);
 	#if WITH_EDITOR
-	DrawDebugLine(GetWorld(), Start, End, FColor::Red, false, -1.f, 0, 1.f);
+	DrawDebugCapsule(GetWorld(), WallStart, CollisionCapsuleHalfHeight, CollisionCapsuleRadius, FQuat::Identity, FColor::Cyan, false, -1, 0, 1);
+	DrawDebugLine(GetWorld(), EyeStart, EyeEnd, FColor::Cyan, false, -1.f, 0, 1.f);
 	#endif
-	return GetWorld()->LineTraceSingleByChannel(UpperEdgeHit, Start, End, ECC_WorldStatic, ClimbQueryParams);
+}
+
+void UACFCharacterMovementComponent::ReadAutoGrabProbes() 
+{
+	if (!AutoGrabWallProbe.IsValid() || !AutoGrabEyeProbe.IsValid()) 
+	{
+		return;
+	}
+
+	FTraceDatum WallDatum;
+	FTraceDatum EyeDatum;
+	if (!GetWorld()->QueryTraceData(AutoGrabWallProbe, WallDatum) || !GetWorld()->QueryTraceData(AutoGrabEyeProbe, EyeDatum)) 
+	{
+		return;
+	}
+
+	AutoGrabWallProbe = FTraceHandle();
+	AutoGrabEyeProbe = FTraceHandle();
+
+	const bool bIsFacingSurface = EyeDatum.OutHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	const FVector Forward = UpdatedComponent->GetForwardVector();
+
+	AutoGrabHits.Reset();
+	if (bIsFacingSurface) 
+	{
+		for (const FHitResult& Hit : WallDatum.OutHits) 
+		{
+			if (Hit.bBlockingHit && IsWallAngleClimbable(Hit, Forward)) 
+			{
+				AutoGrabHits.Add(Hit);
+			}
+		}
+	}
+
+	bAutoGrabArmed = !AutoGrabHits.IsEmpty();
+	if (bAutoGrabArmed) 
+	{
+		AutoGrabContactPoint = AutoGrabHits[0].ImpactPoint;
+		AutoGrabContactNormal = AutoGrabHits[0].Normal.GetSafeNormal2D();
+	}
+}
+
+void UACFCharacterMovementComponent::ResetAutoGrab() noexcept
+{
+	AutoGrabWallProbe = FTraceHandle();
+	AutoGrabEyeProbe = FTraceHandle();
+	AutoGrabHits.Reset();
+	bAutoGrabArmed = false;
+}
+
+bool UACFCharacterMovementComponent::EyeHeightTrace(const float TraceDistance) const noexcept
+{
+	if (!ObstacleProbe) 
+	{
+		FHitResult UpperEdgeHit;
+
+		const FVector Start = UpdatedComponent->GetComponentLocation() + (UpdatedComponent->GetUpVector() * GetCharacterOwner()->BaseEyeHeight);
+		const FVector End = Start + (UpdatedComponent->GetForwardVector() * TraceDistance);
+		return GetWorld()->LineTraceSingleByChannel(UpperEdgeHit, Start, End, ECC_WorldStatic, ClimbQueryParams);
+	}
+
+	// Shared with every other eye height check this frame, the probe traces once at its max distance
+	const FACFObstacleProfile& Profile = ObstacleProbe->GetObstacleProfile(UpdatedComponent->GetForwardVector(), UpdatedComponent->GetUpVector(), EACFObstacleProbeLayer::EyeHeight);
+	return Profile.IsEyeHeightBlockedWithin(TraceDistance);
 }
 
 bool UACFCharacterMovementComponent::IsFacingSurface(const float Steepness) const 
@@ -156,11 +470,44 @@ void UACFCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const
 	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
 }
 
+void UACFCharacterMovementComponent::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	if (const FACFCharacterNetworkMoveData* MoveData = static_cast<const FACFCharacterNetworkMoveData*>(GetCurrentNetworkMoveData())) 
+	{
+		SetClimbingMoveFlags(MoveData->ClimbingFlags);
+	}
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+}
+
+void UACFCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	if (bCancelClimbRequested) 
+	{
+		bWantsToClimb = false;
+	}
+	else if (bClimbRequested && !IsClimbing()) 
+	{
+		EvaluateClimbRequest();
+	}
+
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+}
+
+void UACFCharacterMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateAfterMovement(DeltaSeconds);
+
+	SetClimbingMoveFlags(0);
+	bWallHitsFromAutoGrab = false;
+}
+
 void UACFCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) 
 {
 	if (IsClimbing())
 	{
 		bOrientRotationToMovement = false;
+		ResetSurfaceFilter();
 		
 		// TODO: Check if needed
 		//UCapsuleComponent* Capsule = CharacterOwner->GetCapsuleComponent();
@@ -195,14 +542,17 @@ void UACFCharacterMovementComponent::PhysCustom(float DeltaTime, int32 Iteration
 	Super::PhysCustom(DeltaTime, Iterations);
 }
 
-void UACFCharacterMovementComponent::PhysClimbing_Implementation(float DeltaTime, int32 Iterations) 
+void UACFCharacterMovementComponent::PhysClimbing(float DeltaTime, int32 Iterations) 
 {
 	if(DeltaTime < MIN_TICK_TIME)
 	{
 		return;
 	}
 
-	ComputeSurfaceInfo();
+	// Swept from this move's position, so replays after a correction see the same walls the server did
+	SweepAndStoreWallHits();
+
+	ComputeSurfaceInfo(DeltaTime);
 
 	if (ShouldStopClimbing() || ClimbDownToFloor())
 	{
@@ -227,33 +577,77 @@ void UACFCharacterMovementComponent::PhysClimbing_Implementation(float DeltaTime
 
 }
 
-void UACFCharacterMovementComponent::ComputeSurfaceInfo() 
+void UACFCharacterMovementComponent::ComputeSurfaceInfo(float DeltaTime) 
 {
-	CurrentClimbingNormal = FVector::ZeroVector;
-	CurrentClimbingPosition = FVector::ZeroVector;
-
 	if (CurrentWallHits.IsEmpty()) 
 	{
+		CurrentClimbingNormal = FVector::ZeroVector;
+		CurrentClimbingPosition = FVector::ZeroVector;
+		ResetSurfaceFilter();
+		UpdateReplicatedClimbingNormal();
 		return;
 	}
 
 	const FVector Start = UpdatedComponent->GetComponentLocation();
 	const FCollisionShape CollisionSphere = FCollisionShape::MakeSphere(6);
 
+	FVector RawNormal = FVector::ZeroVector;
+	FVector RawPosition = FVector::ZeroVector;
+	int32 AcceptedHits = 0;
+
+	FVector AllNormals = FVector::ZeroVector;
+	FVector AllPositions = FVector::ZeroVector;
+	int32 BlockingHits = 0;
+
 	for (const auto& Hit : CurrentWallHits) 
 	{
 		const FVector End = Start + (Hit.ImpactPoint - Start).GetSafeNormal() * 120.f;
 
 		// TODO: Check if in more complex scenarios this is really needed, simple ones like flat surface don't
 		FHitResult AssistHit;
-		GetWorld()->SweepSingleByChannel(AssistHit, Start, End, FQuat::Identity, ECC_WorldStatic, CollisionSphere, ClimbQueryParams);
+		if (!GetWorld()->SweepSingleByChannel(AssistHit, Start, End, FQuat::Identity, ECC_WorldStatic, CollisionSphere, ClimbQueryParams))
+		{
+			continue;
+		}
+
+		AllPositions += AssistHit.ImpactPoint;
+		AllNormals += AssistHit.Normal;
+		++BlockingHits;
+
+		if (IsSurfaceNormalOutlier(AssistHit.Normal))
+		{
+			continue;
+		}
+
+		RawPosition += AssistHit.ImpactPoint;
+		RawNormal += AssistHit.Normal;
+		++AcceptedHits;
+	}
 
-		CurrentClimbingPosition += AssistHit.ImpactPoint;
-		CurrentClimbingNormal += AssistHit.Normal;
+	if (BlockingHits == 0)
+	{
+		CurrentClimbingNormal = FVector::ZeroVector;
+		CurrentClimbingPosition = FVector::ZeroVector;
+		ResetSurfaceFilter();
+		UpdateReplicatedClimbingNormal();
+		return;
 	}
 
-	CurrentClimbingPosition /= CurrentWallHits.Num();
-	CurrentClimbingNormal = CurrentClimbingNormal.GetSafeNormal();
+	// Every hit disagreeing with the filtered normal means the surface itself changed, e.g. a corner
+	if (AcceptedHits == 0)
+	{
+		RawPosition = AllPositions;
+		RawNormal = AllNormals;
+		AcceptedHits = BlockingHits;
+	}
+
+	RawPosition /= AcceptedHits;
+	RawNormal = RawNormal.GetSafeNormal();
+
+	CurrentClimbingNormal = FilterSurfaceVector(NormalFilterState, RawNormal, OneEuroNormalBeta, DeltaTime).GetSafeNormal();
+	CurrentClimbingPosition = FilterSurfaceVector(PositionFilterState, RawPosition, OneEuroPositionBeta, DeltaTime);
+
+	UpdateReplicatedClimbingNormal();
 
 	#if WITH_EDITOR
 	DrawDebugSphere(GetWorld(), CurrentClimbingPosition, 5.f, 8, FColor::Blue, false, -1.f, 0, .5f);
@@ -262,6 +656,64 @@ void UACFCharacterMovementComponent::ComputeSurfaceInfo()
 
 }
 
+bool UACFCharacterMovementComponent::IsSurfaceNormalOutlier(const FVector& Normal) const noexcept
+{
+	if (!NormalFilterState.bInitialized || SurfaceFilter == EACFClimbingSurfaceFilter::None) 
+	{
+		return false;
+	}
+
+	const float CosTolerance = FMath::Cos(FMath::DegreesToRadians(OutlierRejectionDegrees));
+	return FVector::DotProduct(Normal, NormalFilterState.Value.GetSafeNormal()) < CosTolerance;
+}
+
+FVector UACFCharacterMovementComponent::FilterSurfaceVector(FACFSurfaceFilterState& State, const FVector& RawValue, const float Beta, const float DeltaTime) const noexcept
+{
+	if (!State.bInitialized || SurfaceFilter == EACFClimbingSurfaceFilter::None || DeltaTime <= 0.f) 
+	{
+		State.Value = RawValue;
+		State.Derivative = FVector::ZeroVector;
+		State.bInitialized = true;
+		return RawValue;
+	}
+
+	float Alpha = 1.f;
+	if (SurfaceFilter == EACFClimbingSurfaceFilter::Exponential) 
+	{
+		Alpha = 1.f - FMath::Exp(-DeltaTime / SurfaceSmoothingTime);
+	}
+	else 
+	{
+		// The cutoff follows the filtered rate of change, so fast changes are tracked and small jitter is smoothed away
+		const FVector RawDerivative = (RawValue - State.Value) / DeltaTime;
+		State.Derivative = FMath::Lerp(State.Derivative, RawDerivative, OneEuroAlpha(DeltaTime, OneEuroDerivativeCutoff));
+
+		const float Cutoff = OneEuroMinCutoff + Beta * State.Derivative.Size();
+		Alpha = OneEuroAlpha(DeltaTime, Cutoff);
+	}
+
+	State.Value = FMath::Lerp(State.Value, RawValue, Alpha);
+	return State.Value;
+}
+
+void UACFCharacterMovementComponent::ResetSurfaceFilter() noexcept
+{
+	NormalFilterState.Reset();
+	PositionFilterState.Reset();
+}
+
+void UACFCharacterMovementComponent::UpdateReplicatedClimbingNormal()
+{
+	const float CosTolerance = FMath::Cos(FMath::DegreesToRadians(NormalReplicationToleranceDegrees));
+	const bool bIsWithinTolerance = FVector::DotProduct(FVector(ReplicatedClimbingNormal), CurrentClimbingNormal) >= CosTolerance;
+
+	// Going to or from a zero normal always replicates, so clients see climbing stop
+	if (!bIsWithinTolerance || CurrentClimbingNormal.IsZero() != ReplicatedClimbingNormal.IsZero())
+	{
+		ReplicatedClimbingNormal = CurrentClimbingNormal;
+	}
+}
+
 void UACFCharacterMovementComponent::ComputeClimbingVelocity(float DeltaTime) 
 {
 	RestorePreAdditiveRootMotionVelocity();
@@ -363,7 +815,7 @@ bool UACFCharacterMovementComponent::TryClimbUpLedge() const
 	const float UpSpeed = FVector::DotProduct(Velocity, UpdatedComponent->GetUpVector());
 	const bool bIsMovingUp = UpSpeed >= MaxClimbingSpeed / 10;
 
-	if (bIsMovingUp && HasReachedEdge() && CanMoveToLedgeClimbLocation()) 
+	if ((bIsMovingUp || bLedgeClimbRequested) && HasReachedEdge() && CanMoveToLedgeClimbLocation()) 
 	{
 		const FRotator StandRotation = FRotator(0, UpdatedComponent->GetComponentRotation().Yaw, 0);
 		UpdatedComponent->SetRelativeRotation(StandRotation);
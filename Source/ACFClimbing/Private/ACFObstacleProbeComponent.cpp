@@ -0,0 +1,157 @@
+#include "ACFObstacleProbeComponent.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+namespace
+{
+// Moving less than this between two requests in the same frame still reuses the cached profile
+constexpr float CACHE_LOCATION_TOLERANCE = 1.f;
+constexpr float CACHE_DIRECTION_TOLERANCE = .999f;
+
+constexpr float DEFAULT_WALKABLE_FLOOR_Z = .71f;
+}
+
+UACFObstacleProbeComponent::UACFObstacleProbeComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UACFObstacleProbeComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	ProbeQueryParams.AddIgnoredActor(GetOwner());
+}
+
+const FACFObstacleProfile& UACFObstacleProbeComponent::GetObstacleProfile(const FVector& Direction, const FVector& Up, EACFObstacleProbeLayer Layers)
+{
+	const FVector Origin = GetOwner()->GetActorLocation();
+
+	if (!IsCacheValid(Origin, Direction, Up))
+	{
+		CachedProfile = FACFObstacleProfile();
+		CachedLayers = EACFObstacleProbeLayer::None;
+		CachedFrame = GFrameCounter;
+		CachedOrigin = Origin;
+		CachedDirection = Direction;
+		CachedUp = Up;
+	}
+
+	if (EnumHasAnyFlags(Layers, EACFObstacleProbeLayer::Ledge))
+	{
+		Layers |= EACFObstacleProbeLayer::Wall;
+	}
+
+	if (EnumHasAnyFlags(Layers, EACFObstacleProbeLayer::Wall) && !EnumHasAnyFlags(CachedLayers, EACFObstacleProbeLayer::Wall))
+	{
+		ProbeWall(Origin, Direction);
+		CachedLayers |= EACFObstacleProbeLayer::Wall;
+	}
+
+	if (EnumHasAnyFlags(Layers, EACFObstacleProbeLayer::EyeHeight) && !EnumHasAnyFlags(CachedLayers, EACFObstacleProbeLayer::EyeHeight))
+	{
+		ProbeEyeHeight(Origin, Direction, Up);
+		CachedLayers |= EACFObstacleProbeLayer::EyeHeight;
+	}
+
+	if (EnumHasAnyFlags(Layers, EACFObstacleProbeLayer::Ledge) && !EnumHasAnyFlags(CachedLayers, EACFObstacleProbeLayer::Ledge))
+	{
+		ProbeLedge(Origin, Direction, Up);
+		CachedLayers |= EACFObstacleProbeLayer::Ledge;
+	}
+
+	return CachedProfile;
+}
+
+FACFObstacleProfile UACFObstacleProbeComponent::GetForwardObstacleProfile()
+{
+	const AActor* Owner = GetOwner();
+	return GetObstacleProfile(Owner->GetActorForwardVector(), Owner->GetActorUpVector(), EACFObstacleProbeLayer::Wall | EACFObstacleProbeLayer::EyeHeight | EACFObstacleProbeLayer::Ledge);
+}
+
+bool UACFObstacleProbeComponent::IsCacheValid(const FVector& Origin, const FVector& Direction, const FVector& Up) const noexcept
+{
+	return CachedFrame == GFrameCounter
+		&& FVector::DistSquared(Origin, CachedOrigin) <= FMath::Square(CACHE_LOCATION_TOLERANCE)
+		&& FVector::DotProduct(Direction, CachedDirection) >= CACHE_DIRECTION_TOLERANCE
+		&& FVector::DotProduct(Up, CachedUp) >= CACHE_DIRECTION_TOLERANCE;
+}
+
+void UACFObstacleProbeComponent::ProbeWall(const FVector& Origin, const FVector& Direction)
+{
+	const FVector End = Origin + Direction * ProbeDistance;
+
+	FHitResult WallHit;
+	const bool bHitWall = WallProbeRadius > 0.f ?
+		GetWorld()->SweepSingleByChannel(WallHit, Origin, End, FQuat::Identity, ProbeChannel, FCollisionShape::MakeSphere(WallProbeRadius), ProbeQueryParams) :
+		GetWorld()->LineTraceSingleByChannel(WallHit, Origin, End, ProbeChannel, ProbeQueryParams);
+
+	CachedProfile.bHasWall = bHitWall;
+	if (bHitWall)
+	{
+		CachedProfile.WallDistance = WallHit.Distance;
+		CachedProfile.WallNormal = WallHit.ImpactNormal;
+		CachedProfile.WallImpactPoint = WallHit.ImpactPoint;
+	}
+}
+
+void UACFObstacleProbeComponent::ProbeEyeHeight(const FVector& Origin, const FVector& Direction, const FVector& Up)
+{
+	const FVector Start = Origin + Up * GetEyeHeight();
+	const FVector End = Start + Direction * ProbeDistance;
+
+	FHitResult EyeHit;
+	CachedProfile.bIsEyeHeightBlocked = GetWorld()->LineTraceSingleByChannel(EyeHit, Start, End, ProbeChannel, ProbeQueryParams);
+	CachedProfile.EyeHeightDistance = CachedProfile.bIsEyeHeightBlocked ? EyeHit.Distance : 0.f;
+
+	#if WITH_EDITOR
+	DrawDebugLine(GetWorld(), Start, CachedProfile.bIsEyeHeightBlocked ? EyeHit.ImpactPoint : End, FColor::Red, false, -1.f, 0, 1.f);
+	#endif
+}
+
+void UACFObstacleProbeComponent::ProbeLedge(const FVector& Origin, const FVector& Direction, const FVector& Up)
+{
+	CachedProfile.TopHeight = 0.f;
+	CachedProfile.bHasLedge = false;
+
+	if (!CachedProfile.bHasWall)
+	{
+		return;
+	}
+
+	// Look down onto the wall from the highest ledge we care about, just past its face
+	const FVector WallHeightPoint = FVector::PointPlaneProject(CachedProfile.WallImpactPoint, Origin, Up);
+	const FVector Start = WallHeightPoint + Direction * LedgeProbeDepth + Up * MaxLedgeHeight;
+	const FVector End = WallHeightPoint + Direction * LedgeProbeDepth;
+
+	FHitResult TopHit;
+	if (!GetWorld()->LineTraceSingleByChannel(TopHit, Start, End, ProbeChannel, ProbeQueryParams))
+	{
+		return;
+	}
+
+	if (TopHit.bStartPenetrating)
+	{
+		CachedProfile.TopHeight = MaxLedgeHeight;
+		return;
+	}
+
+	CachedProfile.TopHeight = FVector::DotProduct(TopHit.ImpactPoint - Origin, Up);
+	CachedProfile.bHasLedge = FVector::DotProduct(TopHit.ImpactNormal, Up) >= GetWalkableFloorZ();
+
+	#if WITH_EDITOR
+	DrawDebugLine(GetWorld(), Start, TopHit.ImpactPoint, CachedProfile.bHasLedge ? FColor::Green : FColor::Orange, false, -1.f, 0, 1.f);
+	#endif
+}
+
+float UACFObstacleProbeComponent::GetEyeHeight() const
+{
+	const APawn* PawnOwner = Cast<APawn>(GetOwner());
+	return PawnOwner ? PawnOwner->BaseEyeHeight : 0.f;
+}
+
+float UACFObstacleProbeComponent::GetWalkableFloorZ() const
+{
+	const ACharacter* CharacterOwner = Cast<ACharacter>(GetOwner());
+	return CharacterOwner ? CharacterOwner->GetCharacterMovement()->GetWalkableFloorZ() : DEFAULT_WALKABLE_FLOOR_Z;
+}
@@ -0,0 +1,105 @@
+#include "ACFPlayerInfoSubsystem.h"
+
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "ACFCharacterMovementComponent.h"
+#include "Engine/World.h"
+
+TConstArrayView<FACFPlayerSnapshot> UACFPlayerInfoSubsystem::GetPlayers()
+{
+	UpdateSnapshots();
+	return Players;
+}
+
+const FACFPlayerSnapshot* UACFPlayerInfoSubsystem::GetPlayer(const int32 PlayerIndex)
+{
+	UpdateSnapshots();
+	return Players.IsValidIndex(PlayerIndex) ? &Players[PlayerIndex] : nullptr;
+}
+
+const FACFPlayerSnapshot* UACFPlayerInfoSubsystem::FindNearestPlayer(const FVector& Location, float& OutDistance)
+{
+	int32 PlayerIndex = INDEX_NONE;
+	FindNearestPlayers(MakeArrayView(&Location, 1), MakeArrayView(&PlayerIndex, 1), MakeArrayView(&OutDistance, 1));
+
+	return PlayerIndex != INDEX_NONE ? &Players[PlayerIndex] : nullptr;
+}
+
+void UACFPlayerInfoSubsystem::FindNearestPlayers(TConstArrayView<FVector> Locations, TArrayView<int32> OutPlayerIndices, TArrayView<float> OutDistances)
+{
+	check(OutPlayerIndices.Num() == Locations.Num() && OutDistances.Num() == Locations.Num());
+
+	UpdateSnapshots();
+
+	const int32 NumPlayers = Players.Num();
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		const FVector& Location = Locations[i];
+
+		int32 BestIndex = INDEX_NONE;
+		double BestDistanceSquared = TNumericLimits<double>::Max();
+
+		// Branch-light loop over the split axes, there are only ever a handful of players
+		for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers; ++PlayerIndex)
+		{
+			const double DX = PlayerX[PlayerIndex] - Location.X;
+			const double DY = PlayerY[PlayerIndex] - Location.Y;
+			const double DZ = PlayerZ[PlayerIndex] - Location.Z;
+			const double DistanceSquared = DX * DX + DY * DY + DZ * DZ;
+
+			if (DistanceSquared < BestDistanceSquared)
+			{
+				BestDistanceSquared = DistanceSquared;
+				BestIndex = PlayerIndex;
+			}
+		}
+
+		OutPlayerIndices[i] = BestIndex;
+		OutDistances[i] = BestIndex != INDEX_NONE ? FMath::Sqrt(BestDistanceSquared) : TNumericLimits<float>::Max();
+	}
+}
+
+void UACFPlayerInfoSubsystem::UpdateSnapshots()
+{
+	if (SnapshotFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	SnapshotFrame = GFrameCounter;
+
+	Players.Reset();
+	PlayerX.Reset();
+	PlayerY.Reset();
+	PlayerZ.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (!IsValid(Pawn))
+		{
+			continue;
+		}
+
+		FACFPlayerSnapshot& Snapshot = Players.AddDefaulted_GetRef();
+		Snapshot.Pawn = Pawn;
+		Snapshot.Character = Cast<ACharacter>(Pawn);
+		Snapshot.Location = Pawn->GetActorLocation();
+		Snapshot.Velocity = Pawn->GetVelocity();
+
+		if (Snapshot.Character)
+		{
+			const UCharacterMovementComponent* Movement = Snapshot.Character->GetCharacterMovement();
+			Snapshot.bGrounded = Movement->IsMovingOnGround();
+
+			const UACFCharacterMovementComponent* ClimbingMovement = Cast<UACFCharacterMovementComponent>(Movement);
+			Snapshot.bClimbing = ClimbingMovement && ClimbingMovement->IsClimbing();
+		}
+
+		PlayerX.Add(Snapshot.Location.X);
+		PlayerY.Add(Snapshot.Location.Y);
+		PlayerZ.Add(Snapshot.Location.Z);
+	}
+}
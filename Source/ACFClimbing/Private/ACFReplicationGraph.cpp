@@ -0,0 +1,205 @@
+#include "ACFReplicationGraph.h"
+
+#include "ReplicationGraphTypes.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Info.h"
+#include "Engine/LevelScriptActor.h"
+#include "Components/SceneComponent.h"
+#include "ACFClimbingCharacter.h"
+#include "CombatEnemy.h"
+#include "CombatDamageableBox.h"
+#include "CombatEventChannel.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogACFReplicationGraph, Log, All);
+
+namespace
+{
+bool IsSkippedClass(const UClass* Class) noexcept
+{
+	// Blueprint compilation leftovers
+	return Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"));
+}
+
+bool IsSpatialized(const EACFClassRepNodeMapping Mapping) noexcept
+{
+	return Mapping >= EACFClassRepNodeMapping::Spatialize_Static;
+}
+}
+
+UACFReplicationGraph::UACFReplicationGraph()
+{
+}
+
+void UACFReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	ClassRepNodePolicies.Set(AInfo::StaticClass(), EACFClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(AGameStateBase::StaticClass(), EACFClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(APlayerState::StaticClass(), EACFClassRepNodeMapping::RelevantAllConnections);
+	ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EACFClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APlayerController::StaticClass(), EACFClassRepNodeMapping::NotRouted);
+	ClassRepNodePolicies.Set(APawn::StaticClass(), EACFClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(AACFClimbingCharacter::StaticClass(), EACFClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(ACombatEnemy::StaticClass(), EACFClassRepNodeMapping::Spatialize_Dynamic);
+	ClassRepNodePolicies.Set(ACombatDamageableBox::StaticClass(), EACFClassRepNodeMapping::Spatialize_Dormancy);
+	ClassRepNodePolicies.Set(ACombatEventChannel::StaticClass(), EACFClassRepNodeMapping::Spatialize_Static);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated() || IsSkippedClass(Class))
+		{
+			continue;
+		}
+
+		RegisterClassSettings(Class);
+	}
+}
+
+void UACFReplicationGraph::RegisterClassSettings(UClass* Class)
+{
+	const AActor* ActorCDO = GetDefault<AActor>(Class);
+
+	const EACFClassRepNodeMapping Mapping = ComputeMappingPolicy(Class);
+	ClassRepNodePolicies.Set(Class, Mapping);
+
+	FClassReplicationInfo ClassInfo;
+
+	// The graph is frame based, convert the update frequency to a period based on the server tick rate
+	ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->GetNetUpdateFrequency());
+
+	if (IsSpatialized(Mapping))
+	{
+		const float CullDistanceSquared = ActorCDO->GetNetCullDistanceSquared();
+		ClassInfo.SetCullDistanceSquared(CullDistanceSquared > 0.f ? CullDistanceSquared : FMath::Square(DefaultCullDistance));
+	}
+	else
+	{
+		ClassInfo.SetCullDistanceSquared(0.f);
+	}
+
+	GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+
+	UE_LOG(LogACFReplicationGraph, Verbose, TEXT("%s routed as %s"), *Class->GetName(), *UEnum::GetValueAsString(Mapping));
+}
+
+EACFClassRepNodeMapping UACFReplicationGraph::GetMappingPolicy(const UClass* Class) const
+{
+	const EACFClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class);
+	return Mapping ? *Mapping : EACFClassRepNodeMapping::NotRouted;
+}
+
+EACFClassRepNodeMapping UACFReplicationGraph::ComputeMappingPolicy(const UClass* Class) const
+{
+	// Explicit policies set for the class or any of its parents win
+	if (const EACFClassRepNodeMapping* Mapping = ClassRepNodePolicies.Get(Class))
+	{
+		return *Mapping;
+	}
+
+	const AActor* ActorCDO = GetDefault<AActor>(const_cast<UClass*>(Class));
+
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return EACFClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	// Owner-only actors reach their connection through the owner's always relevant node
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EACFClassRepNodeMapping::NotRouted;
+	}
+
+	const USceneComponent* RootComponent = ActorCDO->GetRootComponent();
+	if (RootComponent && RootComponent->Mobility == EComponentMobility::Static)
+	{
+		return EACFClassRepNodeMapping::Spatialize_Static;
+	}
+
+	return ActorCDO->NetDormancy > DORM_Awake ? EACFClassRepNodeMapping::Spatialize_Dormancy : EACFClassRepNodeMapping::Spatialize_Dynamic;
+}
+
+void UACFReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+
+	// Moving actors in each cell are bucketed per connection by distance and view direction, so far climbers update less often
+	GridNode->CreateCellNodeOverride = [](UReplicationGraphNode_GridCell* NewCell)
+	{
+		NewCell->CreateDynamicNodeOverride = [](UReplicationGraphNode_GridCell* Parent)
+		{
+			return Parent->CreateChildNode<UReplicationGraphNode_DynamicSpatialFrequency>();
+		};
+	};
+
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UACFReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// The connection's own controller and view target are always relevant to it
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void UACFReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EACFClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UACFReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetMappingPolicy(ActorInfo.Class))
+	{
+	case EACFClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EACFClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
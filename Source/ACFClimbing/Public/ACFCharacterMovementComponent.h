@@ -2,8 +2,97 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/NetSerialization.h"
+#include "WorldCollision.h"
 #include "ACFCharacterMovementComponent.generated.h"
 
+class UACFObstacleProbeComponent;
+
+// Climbing inputs carried by every saved move, so they are replayed and sent along with the standard move
+enum class EACFClimbingMoveFlags : uint8
+{
+	None			= 0,
+	RequestClimb	= 1 << 0,
+	CancelClimb		= 1 << 1,
+	LedgeClimb		= 1 << 2,
+};
+ENUM_CLASS_FLAGS(EACFClimbingMoveFlags);
+
+constexpr uint32 ACF_CLIMBING_MOVE_FLAG_BITS = 3;
+
+// Temporal state for one filtered climbing surface vector (normal or position)
+struct FACFSurfaceFilterState
+{
+	FVector Value = FVector::ZeroVector;
+	FVector Derivative = FVector::ZeroVector;
+	bool bInitialized = false;
+
+	void Reset() noexcept { *this = FACFSurfaceFilterState(); }
+};
+
+// Client-side climbing state at the start of a saved move, restored before the move is replayed after a correction
+struct FACFClimbingMoveState
+{
+	FACFSurfaceFilterState NormalFilterState;
+	FACFSurfaceFilterState PositionFilterState;
+	bool bWantsToClimb = false;
+};
+
+struct FACFCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	uint8 ClimbingFlags = 0;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+struct FACFCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FACFCharacterNetworkMoveDataContainer();
+
+	FACFCharacterNetworkMoveData ACFMoveData[3];
+};
+
+class FSavedMove_ACFCharacter : public FSavedMove_Character
+{
+public:
+	using Super = FSavedMove_Character;
+
+	virtual void Clear() override;
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+	// Climbing moves only combine while on the same surface with the same climbing input
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	// Climbing input changes are resent until acked, like jumps and crouches
+	virtual bool IsImportantMove(const FSavedMovePtr& LastAckedMove) const override;
+
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 ClimbingFlags = 0;
+	FVector_NetQuantizeNormal ClimbSurfaceNormal;
+	FACFClimbingMoveState ClimbingState;
+};
+
+class FNetworkPredictionData_Client_ACFCharacter : public FNetworkPredictionData_Client_Character
+{
+public:
+	explicit FNetworkPredictionData_Client_ACFCharacter(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+UENUM()
+enum class EACFClimbingSurfaceFilter : uint8
+{
+	None,
+	Exponential,
+	// Adaptive low-pass: smooths hard while still, follows quickly while the surface changes fast
+	OneEuro,
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class ACFCLIMBING_API UACFCharacterMovementComponent : public UCharacterMovementComponent
 {
@@ -16,12 +105,15 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
-	UFUNCTION(Server, Reliable)
+	// Climbing requests are sent to the server with the next move
 	void TryClimbing();
 
-	UFUNCTION(Server, Reliable)
 	void CancelClimbing();
 
+	// Climbs up the ledge if possible, even without moving up
+	UFUNCTION(BlueprintCallable)
+	void RequestLedgeClimb();
+
 	UFUNCTION(BlueprintPure)
 	bool IsClimbing() const;
 
@@ -30,6 +122,16 @@ public:
 
 	void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	uint8 GetClimbingMoveFlags() const noexcept;
+
+	void SetClimbingMoveFlags(uint8 Flags) noexcept;
+
+	FACFClimbingMoveState GetClimbingMoveState() const noexcept;
+
+	void SetClimbingMoveState(const FACFClimbingMoveState& State) noexcept;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
@@ -40,20 +142,45 @@ private:
 
 	bool IsWallClimbable(const FHitResult& Hit, const FVector& Forward) const noexcept;
 
+	bool IsWallAngleClimbable(const FHitResult& Hit, const FVector& Forward) const noexcept;
+
+	void UpdateAutoGrab();
+
+	void IssueAutoGrabProbes();
+
+	void ReadAutoGrabProbes();
+
+	void ResetAutoGrab() noexcept;
+
 	bool EyeHeightTrace(float TraceDistance) const noexcept;
 
 	bool IsFacingSurface(float Steepness) const;
 
 	void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
 
+	void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+
+	void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
+
+	void EvaluateClimbRequest();
+
 	void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
 
 	void PhysCustom(float DeltaTime, int32 Iterations) override;
 
-	UFUNCTION(Server, Reliable)
 	void PhysClimbing(float DeltaTime, int32 Iterations);
 
-	void ComputeSurfaceInfo();
+	void ComputeSurfaceInfo(float DeltaTime);
+
+	bool IsSurfaceNormalOutlier(const FVector& Normal) const noexcept;
+
+	FVector FilterSurfaceVector(FACFSurfaceFilterState& State, const FVector& RawValue, float Beta, float DeltaTime) const noexcept;
+
+	void ResetSurfaceFilter() noexcept;
+
+	void UpdateReplicatedClimbingNormal();
 	
 	void ComputeClimbingVelocity(float DeltaTime);
 	
@@ -120,16 +247,84 @@ private:
 	UPROPERTY(Category = "Character Movement: Climbing", EditDefaultsOnly)
 	TObjectPtr<UAnimMontage> LedgeClimbMontage;
 
+	// Grab climbable walls while falling without pressing Climb, using async probes along the predicted trajectory
+	UPROPERTY(Category = "Character Movement: Climbing|Auto Grab", EditAnywhere)
+	bool bAutoGrabWhileFalling = false;
+
+	// How far ahead along the fall trajectory the probes are issued, in seconds
+	UPROPERTY(Category = "Character Movement: Climbing|Auto Grab", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "0.5", EditCondition = "bAutoGrabWhileFalling"))
+	float AutoGrabLookAheadTime = 0.1f;
+
+	UPROPERTY(Category = "Character Movement: Climbing|Auto Grab", EditAnywhere, meta = (ClampMin = "1.0", ClampMax = "300.0", EditCondition = "bAutoGrabWhileFalling"))
+	float AutoGrabProbeDistance = 80.f;
+
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere)
+	EACFClimbingSurfaceFilter SurfaceFilter = EACFClimbingSurfaceFilter::OneEuro;
+
+	// Time constant of the exponential filter, in seconds
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.001", ClampMax = "1.0", EditCondition = "SurfaceFilter == EACFClimbingSurfaceFilter::Exponential"))
+	float SurfaceSmoothingTime = 0.08f;
+
+	// Cutoff frequency used by the one-euro filter when the surface is not changing, in Hz
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.01", ClampMax = "30.0", EditCondition = "SurfaceFilter == EACFClimbingSurfaceFilter::OneEuro"))
+	float OneEuroMinCutoff = 1.5f;
+
+	// How much the cutoff grows with the rate of change of the normal
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "10.0", EditCondition = "SurfaceFilter == EACFClimbingSurfaceFilter::OneEuro"))
+	float OneEuroNormalBeta = 0.5f;
+
+	// How much the cutoff grows with the speed of the surface position, per cm/s
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "SurfaceFilter == EACFClimbingSurfaceFilter::OneEuro"))
+	float OneEuroPositionBeta = 0.01f;
+
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.01", ClampMax = "30.0", EditCondition = "SurfaceFilter == EACFClimbingSurfaceFilter::OneEuro"))
+	float OneEuroDerivativeCutoff = 1.f;
+
+	// Assist hits whose normal deviates more than this from the filtered normal are ignored, unless every hit does
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "1.0", ClampMax = "180.0"))
+	float OutlierRejectionDegrees = 35.f;
+
+	// The replicated normal is only updated once the filtered one has drifted more than this
+	UPROPERTY(Category = "Character Movement: Climbing|Surface Filter", EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "30.0"))
+	float NormalReplicationToleranceDegrees = 2.f;
+
 	UPROPERTY()
 	TObjectPtr<UAnimInstance> AnimInstance;
 
+	UPROPERTY()
+	TObjectPtr<UACFObstacleProbeComponent> ObstacleProbe;
+
 	TArray<FHitResult> CurrentWallHits;
 	FCollisionQueryParams ClimbQueryParams;
 
-	UPROPERTY(replicated)
 	FVector CurrentClimbingNormal;
 	FVector CurrentClimbingPosition;
 
+	FACFSurfaceFilterState NormalFilterState;
+	FACFSurfaceFilterState PositionFilterState;
+
+	UPROPERTY(replicated)
+	FVector_NetQuantizeNormal ReplicatedClimbingNormal;
+
 	bool bWantsToClimb;
 
+	// Pending climbing inputs, consumed by the next move
+	bool bClimbRequested = false;
+	bool bCancelClimbRequested = false;
+	bool bLedgeClimbRequested = false;
+
+	FACFCharacterNetworkMoveDataContainer ACFMoveDataContainer;
+
+	FTraceHandle AutoGrabWallProbe;
+	FTraceHandle AutoGrabEyeProbe;
+
+	// Result of the last completed auto grab probes, ready to be used once the wall is within reach
+	TArray<FHitResult> AutoGrabHits;
+	FVector AutoGrabContactPoint = FVector::ZeroVector;
+	FVector AutoGrabContactNormal = FVector::ZeroVector;
+	bool bAutoGrabArmed = false;
+
+	// The next climb request reads the auto grab probe hits already in CurrentWallHits instead of sweeping
+	bool bWallHitsFromAutoGrab = false;
+
 };
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ACFObstacleProbeComponent.generated.h"
+
+// Parts of the obstacle profile a caller needs; missing parts are probed lazily
+enum class EACFObstacleProbeLayer : uint8
+{
+	None		= 0,
+	Wall		= 1 << 0,
+	EyeHeight	= 1 << 1,
+	// Implies Wall
+	Ledge		= 1 << 2,
+};
+ENUM_CLASS_FLAGS(EACFObstacleProbeLayer);
+
+USTRUCT(BlueprintType)
+struct FACFObstacleProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	bool bHasWall = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	float WallDistance = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	FVector WallNormal = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	FVector WallImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	bool bIsEyeHeightBlocked = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	float EyeHeightDistance = 0.f;
+
+	// Height of the top of the wall above the probe origin, clamped to MaxLedgeHeight
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	float TopHeight = 0.f;
+
+	// The top of the wall is within MaxLedgeHeight and walkable
+	UPROPERTY(BlueprintReadOnly, Category = "Obstacle")
+	bool bHasLedge = false;
+
+	bool HasWallWithin(float Distance) const noexcept { return bHasWall && WallDistance <= Distance; }
+
+	bool IsEyeHeightBlockedWithin(float Distance) const noexcept { return bIsEyeHeightBlocked && EyeHeightDistance <= Distance; }
+};
+
+/**
+ * Probes for obstacles in front of its owner and caches the result for the rest of the frame.
+ * Each probe is done once at ProbeDistance, so callers with different reach share it by comparing distances.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class ACFCLIMBING_API UACFObstacleProbeComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UACFObstacleProbeComponent();
+
+	// Profile along Direction, probing only the layers not already computed this frame for the same origin and direction
+	const FACFObstacleProfile& GetObstacleProfile(const FVector& Direction, const FVector& Up, EACFObstacleProbeLayer Layers);
+
+	UFUNCTION(BlueprintCallable, Category = "Obstacle")
+	FACFObstacleProfile GetForwardObstacleProfile();
+
+	UPROPERTY(Category = "Obstacle Probe", EditAnywhere, BlueprintReadOnly)
+	TEnumAsByte<ECollisionChannel> ProbeChannel = ECC_WorldStatic;
+
+	// Longest reach any caller may ask for
+	UPROPERTY(Category = "Obstacle Probe", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "1.0", ClampMax = "2000.0"))
+	float ProbeDistance = 500.f;
+
+	// Radius of the body-height wall sweep, zero uses a line trace
+	UPROPERTY(Category = "Obstacle Probe", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0.0", ClampMax = "200.0"))
+	float WallProbeRadius = 25.f;
+
+	UPROPERTY(Category = "Obstacle Probe", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0.0", ClampMax = "1000.0"))
+	float MaxLedgeHeight = 250.f;
+
+	// How far past the wall face the top of the wall is looked for
+	UPROPERTY(Category = "Obstacle Probe", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "1.0", ClampMax = "200.0"))
+	float LedgeProbeDepth = 30.f;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+
+	bool IsCacheValid(const FVector& Origin, const FVector& Direction, const FVector& Up) const noexcept;
+
+	void ProbeWall(const FVector& Origin, const FVector& Direction);
+
+	void ProbeEyeHeight(const FVector& Origin, const FVector& Direction, const FVector& Up);
+
+	void ProbeLedge(const FVector& Origin, const FVector& Direction, const FVector& Up);
+
+	float GetEyeHeight() const;
+
+	float GetWalkableFloorZ() const;
+
+	FACFObstacleProfile CachedProfile;
+	EACFObstacleProbeLayer CachedLayers = EACFObstacleProbeLayer::None;
+	uint64 CachedFrame = 0;
+	FVector CachedOrigin = FVector::ZeroVector;
+	FVector CachedDirection = FVector::ZeroVector;
+	FVector CachedUp = FVector::ZeroVector;
+
+	FCollisionQueryParams ProbeQueryParams;
+};
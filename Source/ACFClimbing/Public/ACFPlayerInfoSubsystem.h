@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ACFPlayerInfoSubsystem.generated.h"
+
+class APawn;
+class ACharacter;
+
+// What AI needs to know about one player, captured once per frame
+struct FACFPlayerSnapshot
+{
+	// Only valid for the frame the snapshot was taken on, the snapshot is rebuilt before it's read in a new frame
+	APawn* Pawn = nullptr;
+	// Null if the pawn isn't a character
+	ACharacter* Character = nullptr;
+
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	bool bGrounded = false;
+	bool bClimbing = false;
+};
+
+/**
+ * Per-frame cache of every possessed player pawn.
+ * AI tasks, evaluators and EQS contexts read from here instead of looking up, casting and measuring the player themselves,
+ * so the lookups happen once per frame instead of once per AI.
+ */
+UCLASS()
+class ACFCLIMBING_API UACFPlayerInfoSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Every player with a pawn, in player controller order
+	TConstArrayView<FACFPlayerSnapshot> GetPlayers();
+
+	// Snapshot of the Nth player with a pawn, or null if there aren't that many
+	const FACFPlayerSnapshot* GetPlayer(int32 PlayerIndex);
+
+	// Closest player to the location, or null if there are no players
+	const FACFPlayerSnapshot* FindNearestPlayer(const FVector& Location, float& OutDistance);
+
+	// Batched version of FindNearestPlayer for many AI at once. Writes INDEX_NONE and a max distance when there are no players
+	void FindNearestPlayers(TConstArrayView<FVector> Locations, TArrayView<int32> OutPlayerIndices, TArrayView<float> OutDistances);
+
+private:
+	void UpdateSnapshots();
+
+	TArray<FACFPlayerSnapshot> Players;
+
+	// Player locations split by axis, so the batched distance loop reads contiguous floats
+	TArray<double> PlayerX;
+	TArray<double> PlayerY;
+	TArray<double> PlayerZ;
+
+	uint64 SnapshotFrame = MAX_uint64;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ACFReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_AlwaysRelevant_ForConnection;
+
+// How a replicated actor class is routed into the graph
+UENUM()
+enum class EACFClassRepNodeMapping : uint8
+{
+	// Not in any global node, e.g. player controllers which are always relevant to their own connection only
+	NotRouted,
+	RelevantAllConnections,
+
+	// Never move after spawn, only placed in the grid once
+	Spatialize_Static,
+	// Move every frame, e.g. climbers and enemies. Far ones are replicated less often
+	Spatialize_Dynamic,
+	// Static while dormant, treated as dynamic while awake, e.g. physics props
+	Spatialize_Dormancy,
+};
+
+/**
+ * Replication graph for the project.
+ * Pawns are spatialized in a grid with distance based update frequency, game state actors are relevant to everyone
+ * and props only cost anything while they are awake.
+ */
+UCLASS(Transient, config = Engine)
+class ACFCLIMBING_API UACFReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UACFReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+
+	virtual void InitGlobalGraphNodes() override;
+
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	UPROPERTY(config)
+	float GridCellSize = 10000.f;
+
+	// Lowest X and Y any replicated actor is expected at, so the grid doesn't need to grow
+	UPROPERTY(config)
+	FVector2D SpatialBias = FVector2D(-200000.f, -200000.f);
+
+	// Used for spatialized classes that don't set their own net cull distance
+	UPROPERTY(config)
+	float DefaultCullDistance = 15000.f;
+
+private:
+
+	EACFClassRepNodeMapping GetMappingPolicy(const UClass* Class) const;
+
+	EACFClassRepNodeMapping ComputeMappingPolicy(const UClass* Class) const;
+
+	void RegisterClassSettings(UClass* Class);
+
+	// Explicit routing for project classes, looked up through the class hierarchy
+	TClassMap<EACFClassRepNodeMapping> ClassRepNodePolicies;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+};
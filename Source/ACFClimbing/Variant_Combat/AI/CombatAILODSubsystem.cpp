@@ -0,0 +1,201 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAILODSubsystem.h"
+#include "CombatEnemy.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ACFPlayerInfoSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Engaged Enemies"), STAT_CombatAILODEngaged, STATGROUP_CombatAILOD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Near Enemies"), STAT_CombatAILODNear, STATGROUP_CombatAILOD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Far Enemies"), STAT_CombatAILODFar, STATGROUP_CombatAILOD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dormant Enemies"), STAT_CombatAILODDormant, STATGROUP_CombatAILOD);
+
+UCombatAILODSubsystem::UCombatAILODSubsystem()
+{
+	// engaged enemies tick everything every frame
+	TierSettings[static_cast<int32>(ECombatAILODTier::Engaged)] = FCombatAILODTierSettings();
+
+	// near enemies think less often, but keep moving and animating smoothly
+	FCombatAILODTierSettings& Near = TierSettings[static_cast<int32>(ECombatAILODTier::Near)];
+	Near.StateTreeTickInterval = 0.1f;
+
+	// far enemies think, move and animate at reduced rates
+	FCombatAILODTierSettings& Far = TierSettings[static_cast<int32>(ECombatAILODTier::Far)];
+	Far.StateTreeTickInterval = 0.25f;
+	Far.MovementTickInterval = 0.1f;
+	Far.AnimTickInterval = 0.066f;
+	Far.bOnlyTickPoseWhenRendered = true;
+
+	// dormant enemies stop thinking until they're woken up
+	FCombatAILODTierSettings& Dormant = TierSettings[static_cast<int32>(ECombatAILODTier::Dormant)];
+	Dormant.bTickStateTree = false;
+	Dormant.MovementTickInterval = 0.25f;
+	Dormant.AnimTickInterval = 0.25f;
+	Dormant.bOnlyTickPoseWhenRendered = true;
+}
+
+void UCombatAILODSubsystem::RegisterEnemy(ACombatEnemy* Enemy)
+{
+	check(Enemy);
+
+	// ignore enemies we're already managing
+	if (Entries.ContainsByPredicate([Enemy](const FCombatAILODEntry& Entry) { return Entry.Enemy.Get() == Enemy; }))
+	{
+		return;
+	}
+
+	// start engaged so the enemy runs at full rate until the next update sorts it
+	FCombatAILODEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Enemy = Enemy;
+	Entry.Tier = ECombatAILODTier::Engaged;
+	Entry.DefaultAnimTickOption = Enemy->GetMesh()->VisibilityBasedAnimTickOption;
+
+	ApplyTier(Entry, ECombatAILODTier::Engaged);
+}
+
+void UCombatAILODSubsystem::UnregisterEnemy(ACombatEnemy* Enemy)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Enemy](const FCombatAILODEntry& Entry) { return Entry.Enemy.Get() == Enemy; });
+
+	if (Index != INDEX_NONE)
+	{
+		// restore full tick rates so the enemy behaves normally outside of the subsystem
+		ApplyTier(Entries[Index], ECombatAILODTier::Engaged);
+
+		Entries.RemoveAtSwap(Index);
+	}
+}
+
+void UCombatAILODSubsystem::WakeEnemy(ACombatEnemy* Enemy)
+{
+	for (FCombatAILODEntry& Entry : Entries)
+	{
+		if (Entry.Enemy.Get() == Enemy)
+		{
+			// hold the enemy at full rate for a while
+			Entry.EngagedUntil = GetWorld()->GetTimeSeconds() + EngagedHoldTime;
+
+			if (Entry.Tier != ECombatAILODTier::Engaged)
+			{
+				Entry.Tier = ECombatAILODTier::Engaged;
+				ApplyTier(Entry, ECombatAILODTier::Engaged);
+			}
+
+			return;
+		}
+	}
+}
+
+void UCombatAILODSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate >= UpdateInterval)
+	{
+		TimeSinceUpdate = 0.0f;
+		UpdateTiers();
+	}
+}
+
+TStatId UCombatAILODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatAILODSubsystem, STATGROUP_Tickables);
+}
+
+void UCombatAILODSubsystem::UpdateTiers()
+{
+	// drop enemies that were destroyed without unregistering
+	Entries.RemoveAllSwap([](const FCombatAILODEntry& Entry)
+	{
+		return !Entry.Enemy.IsValid();
+	});
+
+	// find the closest player to every enemy in one batched query
+	ScratchLocations.Reset();
+
+	for (const FCombatAILODEntry& Entry : Entries)
+	{
+		ScratchLocations.Add(Entry.Enemy->GetActorLocation());
+	}
+
+	ScratchPlayerIndices.SetNumUninitialized(Entries.Num());
+	ScratchDistances.SetNumUninitialized(Entries.Num());
+
+	GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->FindNearestPlayers(ScratchLocations, ScratchPlayerIndices, ScratchDistances);
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	int32 TierCounts[static_cast<int32>(ECombatAILODTier::Count)] = {};
+
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		FCombatAILODEntry& Entry = Entries[i];
+		ACombatEnemy* Enemy = Entry.Enemy.Get();
+
+		const float Distance = ScratchDistances[i];
+		const bool bVisible = Enemy->GetMesh()->WasRecentlyRendered(UpdateInterval);
+
+		// pick the tier from engagement, distance and visibility
+		ECombatAILODTier NewTier;
+
+		if (Enemy->IsAttacking() || CurrentTime < Entry.EngagedUntil || Distance < EngagedDistance)
+		{
+			NewTier = ECombatAILODTier::Engaged;
+		}
+		else if (bVisible && Distance < NearDistance)
+		{
+			NewTier = ECombatAILODTier::Near;
+		}
+		else if (bVisible || Distance < DormantDistance)
+		{
+			NewTier = ECombatAILODTier::Far;
+		}
+		else
+		{
+			NewTier = ECombatAILODTier::Dormant;
+		}
+
+		// only touch the components when the tier changes
+		if (NewTier != Entry.Tier)
+		{
+			Entry.Tier = NewTier;
+			ApplyTier(Entry, NewTier);
+		}
+
+		++TierCounts[static_cast<int32>(NewTier)];
+	}
+
+	INC_DWORD_STAT_BY(STAT_CombatAILODEngaged, TierCounts[static_cast<int32>(ECombatAILODTier::Engaged)]);
+	INC_DWORD_STAT_BY(STAT_CombatAILODNear, TierCounts[static_cast<int32>(ECombatAILODTier::Near)]);
+	INC_DWORD_STAT_BY(STAT_CombatAILODFar, TierCounts[static_cast<int32>(ECombatAILODTier::Far)]);
+	INC_DWORD_STAT_BY(STAT_CombatAILODDormant, TierCounts[static_cast<int32>(ECombatAILODTier::Dormant)]);
+}
+
+void UCombatAILODSubsystem::ApplyTier(const FCombatAILODEntry& Entry, ECombatAILODTier Tier) const
+{
+	ACombatEnemy* Enemy = Entry.Enemy.Get();
+	const FCombatAILODTierSettings& Settings = TierSettings[static_cast<int32>(Tier)];
+
+	// throttle or pause the StateTree
+	if (const AAIController* AIController = Cast<AAIController>(Enemy->GetController()))
+	{
+		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
+		{
+			BrainComponent->SetComponentTickInterval(Settings.StateTreeTickInterval);
+			BrainComponent->SetComponentTickEnabled(Settings.bTickStateTree);
+		}
+	}
+
+	// throttle movement
+	Enemy->GetCharacterMovement()->SetComponentTickInterval(Settings.MovementTickInterval);
+
+	// throttle animation
+	USkeletalMeshComponent* Mesh = Enemy->GetMesh();
+	Mesh->SetComponentTickInterval(Settings.AnimTickInterval);
+	Mesh->VisibilityBasedAnimTickOption = Settings.bOnlyTickPoseWhenRendered ? EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered : Entry.DefaultAnimTickOption;
+}
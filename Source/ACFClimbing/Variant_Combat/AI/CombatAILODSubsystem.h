@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "CombatAILODSubsystem.generated.h"
+
+class ACombatEnemy;
+
+DECLARE_STATS_GROUP(TEXT("CombatAILOD"), STATGROUP_CombatAILOD, STATCAT_Advanced);
+
+/**
+ *  Significance tier of a combat enemy, from most to least significant
+ */
+enum class ECombatAILODTier : uint8
+{
+	Engaged,
+	Near,
+	Far,
+	Dormant,
+	Count
+};
+
+/**
+ *  Tick rates applied to enemies in a significance tier. Zero intervals tick every frame
+ */
+struct FCombatAILODTierSettings
+{
+	/** If false, the StateTree stops ticking until the enemy is woken up */
+	bool bTickStateTree = true;
+
+	/** Tick interval of the StateTree component */
+	float StateTreeTickInterval = 0.0f;
+
+	/** Tick interval of the character movement component */
+	float MovementTickInterval = 0.0f;
+
+	/** Tick interval of the skeletal mesh */
+	float AnimTickInterval = 0.0f;
+
+	/** If true, the pose is only updated while the mesh is rendered */
+	bool bOnlyTickPoseWhenRendered = false;
+};
+
+/**
+ *  A combat enemy whose tick rates are managed by the subsystem
+ */
+struct FCombatAILODEntry
+{
+	/** Managed enemy */
+	TWeakObjectPtr<ACombatEnemy> Enemy;
+
+	/** Tier currently applied to the enemy */
+	ECombatAILODTier Tier = ECombatAILODTier::Count;
+
+	/** World time until which the enemy is kept engaged after being woken up */
+	float EngagedUntil = 0.0f;
+
+	/** Visibility based anim tick option the mesh had when it was registered, restored outside of the throttled tiers */
+	EVisibilityBasedAnimTickOption DefaultAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+};
+
+/**
+ *  Throttles combat enemy AI, movement and animation based on significance.
+ *  Enemies are periodically sorted into tiers by distance to the closest player, visibility and combat engagement.
+ *  Far enemies tick their StateTree, movement and animation less often, and dormant ones stop running their StateTree
+ *  until a player gets close or they're woken up by an event such as taking damage
+ */
+UCLASS()
+class UCombatAILODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Time between significance updates */
+	float UpdateInterval = 0.2f;
+
+	/** Enemies closer than this to a player are engaged */
+	float EngagedDistance = 1500.0f;
+
+	/** Visible enemies closer than this to a player are near */
+	float NearDistance = 4000.0f;
+
+	/** Enemies further than this from every player go dormant unless they're visible */
+	float DormantDistance = 8000.0f;
+
+	/** Time an enemy stays engaged after being woken up */
+	float EngagedHoldTime = 3.0f;
+
+	/** Tick rates for each tier */
+	FCombatAILODTierSettings TierSettings[static_cast<int32>(ECombatAILODTier::Count)];
+
+	/** Managed enemies */
+	TArray<FCombatAILODEntry> Entries;
+
+	/** Scratch buffers for the batched player distance query */
+	TArray<FVector> ScratchLocations;
+	TArray<int32> ScratchPlayerIndices;
+	TArray<float> ScratchDistances;
+
+	/** Time accumulated since the last significance update */
+	float TimeSinceUpdate = 0.0f;
+
+public:
+
+	/** Sets up the tier settings */
+	UCombatAILODSubsystem();
+
+	/** Starts managing an enemy's tick rates */
+	void RegisterEnemy(ACombatEnemy* Enemy);
+
+	/** Stops managing an enemy and restores its full tick rates */
+	void UnregisterEnemy(ACombatEnemy* Enemy);
+
+	/** Raises an enemy to the engaged tier right away, e.g. when it takes damage */
+	void WakeEnemy(ACombatEnemy* Enemy);
+
+	// ~begin FTickableGameObject interface
+
+	/** Periodically updates the enemy tiers */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+
+protected:
+
+	/** Sorts every managed enemy into a tier and applies any changes */
+	void UpdateTiers();
+
+	/** Applies a tier's tick rates to a managed enemy */
+	void ApplyTier(const FCombatAILODEntry& Entry, ECombatAILODTier Tier) const;
+};
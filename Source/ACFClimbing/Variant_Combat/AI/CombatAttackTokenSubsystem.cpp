@@ -0,0 +1,205 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAttackTokenSubsystem.h"
+#include "CombatEnemy.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attack Tokens Held"), STAT_CombatAttackTokensHeld, STATGROUP_CombatAttackTokens);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Denied Token Requests"), STAT_CombatAttackTokensDenied, STATGROUP_CombatAttackTokens);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Preempted Tokens"), STAT_CombatAttackTokensPreempted, STATGROUP_CombatAttackTokens);
+
+bool UCombatAttackTokenSubsystem::RequestToken(ACombatEnemy* Attacker, const AActor* Target, int32 Priority)
+{
+	check(Attacker);
+
+	if (!Target)
+	{
+		return false;
+	}
+
+	FCombatAttackTokenTarget& TokenTarget = Targets.FindOrAdd(Target);
+	PruneHolders(TokenTarget);
+
+	// do we already hold a token?
+	if (TokenTarget.Holders.ContainsByPredicate([Attacker](const FCombatAttackTokenHolder& Holder) { return Holder.Attacker.Get() == Attacker; }))
+	{
+		return true;
+	}
+
+	// wait until we've recovered from our last attack
+	if (IsOnCooldown(Attacker))
+	{
+		INC_DWORD_STAT(STAT_CombatAttackTokensDenied);
+		return false;
+	}
+
+	// is the target out of tokens?
+	if (TokenTarget.Holders.Num() >= GetMaxTokens(TokenTarget))
+	{
+		// try to take the token from a lower priority enemy that isn't swinging yet
+		const int32 PreemptIndex = FindPreemptibleHolder(TokenTarget, Priority);
+
+		if (PreemptIndex == INDEX_NONE)
+		{
+			INC_DWORD_STAT(STAT_CombatAttackTokensDenied);
+			return false;
+		}
+
+		TokenTarget.Holders.RemoveAtSwap(PreemptIndex);
+
+		DEC_DWORD_STAT(STAT_CombatAttackTokensHeld);
+		INC_DWORD_STAT(STAT_CombatAttackTokensPreempted);
+	}
+
+	// grant the token
+	FCombatAttackTokenHolder& Holder = TokenTarget.Holders.AddDefaulted_GetRef();
+	Holder.Attacker = Attacker;
+	Holder.Priority = Priority;
+	Holder.GrantTime = GetWorld()->GetTimeSeconds();
+
+	INC_DWORD_STAT(STAT_CombatAttackTokensHeld);
+
+	return true;
+}
+
+bool UCombatAttackTokenSubsystem::CanRequestToken(const ACombatEnemy* Attacker, const AActor* Target, int32 Priority) const
+{
+	if (!Target)
+	{
+		return false;
+	}
+
+	if (HasToken(Attacker, Target))
+	{
+		return true;
+	}
+
+	if (IsOnCooldown(Attacker))
+	{
+		return false;
+	}
+
+	const FCombatAttackTokenTarget* TokenTarget = Targets.Find(Target);
+
+	if (!TokenTarget)
+	{
+		return true;
+	}
+
+	// count only the holders that would survive pruning
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	int32 NumHolders = 0;
+
+	for (const FCombatAttackTokenHolder& Holder : TokenTarget->Holders)
+	{
+		if (Holder.Attacker.IsValid() && CurrentTime - Holder.GrantTime <= MaxTokenHoldTime)
+		{
+			++NumHolders;
+		}
+	}
+
+	return NumHolders < GetMaxTokens(*TokenTarget) || FindPreemptibleHolder(*TokenTarget, Priority) != INDEX_NONE;
+}
+
+bool UCombatAttackTokenSubsystem::HasToken(const ACombatEnemy* Attacker, const AActor* Target) const
+{
+	if (const FCombatAttackTokenTarget* TokenTarget = Targets.Find(Target))
+	{
+		return TokenTarget->Holders.ContainsByPredicate([Attacker](const FCombatAttackTokenHolder& Holder) { return Holder.Attacker.Get() == Attacker; });
+	}
+
+	return false;
+}
+
+void UCombatAttackTokenSubsystem::ReleaseToken(ACombatEnemy* Attacker, const AActor* Target)
+{
+	if (FCombatAttackTokenTarget* TokenTarget = Targets.Find(Target))
+	{
+		const int32 Index = TokenTarget->Holders.IndexOfByPredicate([Attacker](const FCombatAttackTokenHolder& Holder) { return Holder.Attacker.Get() == Attacker; });
+
+		if (Index != INDEX_NONE)
+		{
+			TokenTarget->Holders.RemoveAtSwap(Index);
+			DEC_DWORD_STAT(STAT_CombatAttackTokensHeld);
+
+			// give other enemies a chance to attack before this one goes again
+			Cooldowns.Add(Attacker, GetWorld()->GetTimeSeconds() + TokenCooldown);
+		}
+	}
+}
+
+void UCombatAttackTokenSubsystem::ReleaseAllTokens(ACombatEnemy* Attacker)
+{
+	for (TPair<TObjectKey<AActor>, FCombatAttackTokenTarget>& Pair : Targets)
+	{
+		const int32 Removed = Pair.Value.Holders.RemoveAllSwap([Attacker](const FCombatAttackTokenHolder& Holder) { return Holder.Attacker.Get() == Attacker; });
+		DEC_DWORD_STAT_BY(STAT_CombatAttackTokensHeld, Removed);
+	}
+
+	Cooldowns.Remove(Attacker);
+}
+
+void UCombatAttackTokenSubsystem::SetMaxTokens(const AActor* Target, int32 MaxTokens)
+{
+	if (Target)
+	{
+		Targets.FindOrAdd(Target).MaxTokens = MaxTokens;
+	}
+}
+
+int32 UCombatAttackTokenSubsystem::GetNumTokensHeld(const AActor* Target) const
+{
+	const FCombatAttackTokenTarget* TokenTarget = Targets.Find(Target);
+	return TokenTarget ? TokenTarget->Holders.Num() : 0;
+}
+
+int32 UCombatAttackTokenSubsystem::GetMaxTokens(const FCombatAttackTokenTarget& TokenTarget) const
+{
+	return TokenTarget.MaxTokens > 0 ? TokenTarget.MaxTokens : DefaultTokensPerTarget;
+}
+
+int32 UCombatAttackTokenSubsystem::FindPreemptibleHolder(const FCombatAttackTokenTarget& TokenTarget, int32 Priority) const
+{
+	int32 LowestIndex = INDEX_NONE;
+	int32 LowestPriority = Priority;
+
+	for (int32 i = 0; i < TokenTarget.Holders.Num(); ++i)
+	{
+		const FCombatAttackTokenHolder& Holder = TokenTarget.Holders[i];
+
+		// never interrupt an attack that's already playing
+		const ACombatEnemy* HolderEnemy = Holder.Attacker.Get();
+
+		if (HolderEnemy && HolderEnemy->IsAttacking())
+		{
+			continue;
+		}
+
+		if (Holder.Priority < LowestPriority)
+		{
+			LowestPriority = Holder.Priority;
+			LowestIndex = i;
+		}
+	}
+
+	return LowestIndex;
+}
+
+void UCombatAttackTokenSubsystem::PruneHolders(FCombatAttackTokenTarget& TokenTarget) const
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	const int32 Removed = TokenTarget.Holders.RemoveAllSwap([this, CurrentTime](const FCombatAttackTokenHolder& Holder)
+	{
+		return !Holder.Attacker.IsValid() || CurrentTime - Holder.GrantTime > MaxTokenHoldTime;
+	});
+
+	DEC_DWORD_STAT_BY(STAT_CombatAttackTokensHeld, Removed);
+}
+
+bool UCombatAttackTokenSubsystem::IsOnCooldown(const ACombatEnemy* Attacker) const
+{
+	const float* CooldownEnd = Cooldowns.Find(Attacker);
+	return CooldownEnd && GetWorld()->GetTimeSeconds() < *CooldownEnd;
+}
@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CombatAttackTokenSubsystem.generated.h"
+
+class ACombatEnemy;
+
+DECLARE_STATS_GROUP(TEXT("CombatAttackTokens"), STATGROUP_CombatAttackTokens, STATCAT_Advanced);
+
+/**
+ *  An attack token handed out to an enemy
+ */
+struct FCombatAttackTokenHolder
+{
+	/** Enemy holding the token */
+	TWeakObjectPtr<ACombatEnemy> Attacker;
+
+	/** Priority the token was requested with */
+	int32 Priority = 0;
+
+	/** World time the token was granted at */
+	float GrantTime = 0.0f;
+};
+
+/**
+ *  Attack tokens handed out against a single target
+ */
+struct FCombatAttackTokenTarget
+{
+	/** Enemies currently allowed to attack the target */
+	TArray<FCombatAttackTokenHolder, TInlineAllocator<4>> Holders;
+
+	/** Maximum number of tokens for this target. Zero or less uses the subsystem default */
+	int32 MaxTokens = 0;
+};
+
+/**
+ *  Coordinates enemy attacks so only a few enemies attack the same target at once.
+ *  Enemies request a token against their target before attacking and release it when the attack is over.
+ *  When a target runs out of tokens, higher priority requests can take a token from a lower priority holder
+ *  that hasn't started swinging yet. Released tokens put the enemy on a short cooldown before it can attack again
+ */
+UCLASS()
+class UCombatAttackTokenSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Number of enemies allowed to attack the same target at once */
+	int32 DefaultTokensPerTarget = 2;
+
+	/** Time an enemy has to wait after releasing a token before it can get another one */
+	float TokenCooldown = 1.0f;
+
+	/** Tokens held longer than this are reclaimed, in case the holder never released them */
+	float MaxTokenHoldTime = 10.0f;
+
+	/** Tokens handed out, per target */
+	TMap<TObjectKey<AActor>, FCombatAttackTokenTarget> Targets;
+
+	/** World time each enemy's cooldown ends at */
+	TMap<TObjectKey<ACombatEnemy>, float> Cooldowns;
+
+public:
+
+	/** Tries to get a token to attack the target. Returns true if the token was granted or is already held */
+	bool RequestToken(ACombatEnemy* Attacker, const AActor* Target, int32 Priority = 0);
+
+	/** Returns true if a call to RequestToken with the same arguments would succeed right now */
+	bool CanRequestToken(const ACombatEnemy* Attacker, const AActor* Target, int32 Priority = 0) const;
+
+	/** Returns true if the enemy holds a token against the target */
+	bool HasToken(const ACombatEnemy* Attacker, const AActor* Target) const;
+
+	/** Gives the token back and starts the enemy's cooldown */
+	void ReleaseToken(ACombatEnemy* Attacker, const AActor* Target);
+
+	/** Gives back every token held by the enemy without a cooldown, e.g. when it dies */
+	void ReleaseAllTokens(ACombatEnemy* Attacker);
+
+	/** Overrides the number of tokens available for a target. Zero or less restores the default */
+	void SetMaxTokens(const AActor* Target, int32 MaxTokens);
+
+	/** Returns the number of tokens currently held against the target */
+	int32 GetNumTokensHeld(const AActor* Target) const;
+
+protected:
+
+	/** Returns the number of tokens available for the target */
+	int32 GetMaxTokens(const FCombatAttackTokenTarget& TokenTarget) const;
+
+	/** Returns the index of the holder that a request with the given priority could take a token from, if any */
+	int32 FindPreemptibleHolder(const FCombatAttackTokenTarget& TokenTarget, int32 Priority) const;
+
+	/** Drops holders that were destroyed or held their token for too long */
+	void PruneHolders(FCombatAttackTokenTarget& TokenTarget) const;
+
+	/** Returns true if the enemy is still on cooldown */
+	bool IsOnCooldown(const ACombatEnemy* Attacker) const;
+};
@@ -0,0 +1,701 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatCrowd.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/SceneComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "CombatEnemy.h"
+#include "CombatDamageQueueSubsystem.h"
+#include "ACFPlayerInfoSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/NetSerialization.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Targets"), STAT_CombatCrowdTargets, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Movement"), STAT_CombatCrowdMovement, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Ground"), STAT_CombatCrowdGround, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Attacks"), STAT_CombatCrowdAttacks, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Promotion"), STAT_CombatCrowdPromotion, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances"), STAT_CombatCrowdInstances, STATGROUP_CombatCrowd);
+DECLARE_CYCLE_STAT(TEXT("Crowd Replication"), STAT_CombatCrowdReplication, STATGROUP_CombatCrowd);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proxy Agents"), STAT_CombatCrowdProxies, STATGROUP_CombatCrowd);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Promoted Agents"), STAT_CombatCrowdPromoted, STATGROUP_CombatCrowd);
+
+bool FCombatCrowdSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	// the revision goes along so clients see the snapshot change
+	uint32 PackedRevision = static_cast<uint32>(Revision);
+	Ar.SerializeIntPacked(PackedRevision);
+	Revision = static_cast<int32>(PackedRevision);
+
+	uint32 NumAgents = States.Num();
+	Ar.SerializeIntPacked(NumAgents);
+
+	if (Ar.IsLoading())
+	{
+		// reject malformed snapshots before allocating for them
+		if (NumAgents > MaxAgents)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+
+		Locations.SetNumUninitialized(NumAgents);
+		Yaws.SetNumUninitialized(NumAgents);
+		States.SetNumUninitialized(NumAgents);
+	}
+
+	for (uint32 i = 0; i < NumAgents; ++i)
+	{
+		uint32 PackedState = static_cast<uint32>(States[i]);
+		Ar.SerializeInt(PackedState, static_cast<uint32>(ECombatCrowdAgentState::Dead) + 1);
+		States[i] = static_cast<ECombatCrowdAgentState>(PackedState);
+
+		// only proxies are drawn, the others don't need a location
+		if (States[i] == ECombatCrowdAgentState::Proxy)
+		{
+			bOutSuccess &= SerializePackedVector<1, 24>(Locations[i], Ar);
+
+			uint8 PackedYaw = FRotator::CompressAxisToByte(Yaws[i]);
+			Ar << PackedYaw;
+			Yaws[i] = FRotator::DecompressAxisFromByte(PackedYaw);
+		}
+		else if (Ar.IsLoading())
+		{
+			Locations[i] = FVector::ZeroVector;
+			Yaws[i] = 0.0f;
+		}
+	}
+
+	return true;
+}
+
+ACombatCrowd::ACombatCrowd()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// replicate the agent snapshot. The crowd covers a large area, so keep it relevant everywhere
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
+	// create the root
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// create the instanced mesh for the proxy agents. Proxies don't collide, they're promoted before anything can touch them
+	CrowdMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Crowd Mesh"));
+	CrowdMesh->SetupAttachment(RootComponent);
+	CrowdMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	CrowdMesh->SetCanEverAffectNavigation(false);
+}
+
+int32 ACombatCrowd::GetNumLiveAgents() const
+{
+	int32 NumLive = 0;
+
+	for (const ECombatCrowdAgentState State : States)
+	{
+		NumLive += State != ECombatCrowdAgentState::Dead ? 1 : 0;
+	}
+
+	return NumLive;
+}
+
+void ACombatCrowd::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// the crowd only runs where the enemies are spawned. Clients draw the agents from the replicated snapshot,
+	// and see the promoted enemies through their own replication
+	if (GetNetMode() == NM_Client)
+	{
+		// the initial snapshot can arrive before BeginPlay
+		OnRep_Snapshot();
+		return;
+	}
+
+	// size the agent arrays
+	Locations.SetNumUninitialized(CrowdSize);
+	Yaws.SetNumUninitialized(CrowdSize);
+	HPs.Init(AgentMaxHP, CrowdSize);
+	Teams.Init(AgentTeam, CrowdSize);
+	AttackCooldowns.Init(0.0f, CrowdSize);
+	States.Init(ECombatCrowdAgentState::Proxy, CrowdSize);
+	TargetPlayers.SetNumUninitialized(CrowdSize);
+	TargetDistances.SetNumUninitialized(CrowdSize);
+	InstanceTransforms.SetNumUninitialized(CrowdSize);
+
+	// scatter the agents around the actor and drop them on the ground. This only happens once, so the traces are synchronous
+	const FVector Origin = GetActorLocation();
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatCrowdSpawn), false, this);
+
+	for (int32 i = 0; i < CrowdSize; ++i)
+	{
+		const FVector2D Offset = FMath::RandPointInCircle(SpawnRadius);
+
+		Locations[i] = Origin + FVector(Offset.X, Offset.Y, 0.0f);
+
+		FHitResult GroundHit;
+
+		if (GetWorld()->LineTraceSingleByChannel(GroundHit, Locations[i] + FVector(0.0f, 0.0f, SpawnRadius), Locations[i] - FVector(0.0f, 0.0f, SpawnRadius), ECC_WorldStatic, QueryParams))
+		{
+			Locations[i] = GroundHit.ImpactPoint;
+		}
+
+		Yaws[i] = FMath::FRandRange(-180.0f, 180.0f);
+		InstanceTransforms[i] = FTransform(FRotator(0.0f, Yaws[i], 0.0f), Locations[i]);
+	}
+
+	GroundedLocations = Locations;
+
+	// add one instance per agent
+	CrowdMesh->ClearInstances();
+	CrowdMesh->AddInstances(InstanceTransforms, false, true);
+}
+
+void ACombatCrowd::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// destroy the inactive pooled enemies. Promoted ones will destroy themselves since we're no longer bound
+	for (ACombatEnemy* PromotedEnemy : PromotedEnemies)
+	{
+		if (IsValid(PromotedEnemy))
+		{
+			PromotedEnemy->OnEnemyRemovedFromLevel.Unbind();
+		}
+	}
+
+	for (ACombatEnemy* PooledEnemy : EnemyPool)
+	{
+		if (IsValid(PooledEnemy))
+		{
+			PooledEnemy->Destroy();
+		}
+	}
+
+	PromotedEnemies.Empty();
+	PromotedAgents.Empty();
+	EnemyPool.Empty();
+	GroundChecks.Empty();
+}
+
+void ACombatCrowd::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// clients only draw the agents
+	if (GetNetMode() == NM_Client)
+	{
+		UpdateClientAgents(DeltaTime);
+		UpdateInstances();
+		return;
+	}
+
+	UpdateTargets();
+	UpdateGrid();
+	UpdateMovement(DeltaTime);
+	UpdateGround();
+	UpdateAttacks(DeltaTime);
+	UpdatePromotion();
+	UpdateInstances();
+	UpdateSnapshot(DeltaTime);
+
+	INC_DWORD_STAT_BY(STAT_CombatCrowdPromoted, PromotedEnemies.Num());
+}
+
+void ACombatCrowd::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatCrowd, Snapshot);
+}
+
+void ACombatCrowd::UpdateTargets()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdTargets);
+
+	// find the closest player to every agent in one batched query
+	GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->FindNearestPlayers(Locations, TargetPlayers, TargetDistances);
+}
+
+void ACombatCrowd::UpdateGrid()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdMovement);
+
+	GridHeads.Reset();
+	GridNext.SetNumUninitialized(Locations.Num());
+
+	// chain every proxy agent into its cell
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		if (States[i] != ECombatCrowdAgentState::Proxy)
+		{
+			continue;
+		}
+
+		int32& Head = GridHeads.FindOrAdd(GetGridCell(Locations[i]), INDEX_NONE);
+		GridNext[i] = Head;
+		Head = i;
+	}
+}
+
+void ACombatCrowd::UpdateMovement(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdMovement);
+
+	const TConstArrayView<FACFPlayerSnapshot> Players = GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->GetPlayers();
+	const float SeparationRadiusSquared = FMath::Square(SeparationRadius);
+
+	int32 NumProxies = 0;
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		if (States[i] != ECombatCrowdAgentState::Proxy)
+		{
+			continue;
+		}
+
+		++NumProxies;
+
+		FVector& Location = Locations[i];
+
+		// push away from nearby agents
+		FVector Separation = FVector::ZeroVector;
+		const FIntPoint Cell = GetGridCell(Location);
+
+		for (int32 X = -1; X <= 1; ++X)
+		{
+			for (int32 Y = -1; Y <= 1; ++Y)
+			{
+				const int32* Head = GridHeads.Find(FIntPoint(Cell.X + X, Cell.Y + Y));
+
+				for (int32 Other = Head ? *Head : INDEX_NONE; Other != INDEX_NONE; Other = GridNext[Other])
+				{
+					const FVector Offset = Location - Locations[Other];
+					const float DistanceSquared = Offset.SizeSquared2D();
+
+					if (Other != i && DistanceSquared < SeparationRadiusSquared && DistanceSquared > UE_KINDA_SMALL_NUMBER)
+					{
+						const float Distance = FMath::Sqrt(DistanceSquared);
+						Separation += FVector(Offset.X, Offset.Y, 0.0f) / Distance * (1.0f - Distance / SeparationRadius);
+					}
+				}
+			}
+		}
+
+		// seek the closest player if it's in aggro range, but stop at attack range
+		FVector Seek = FVector::ZeroVector;
+		const int32 PlayerIndex = TargetPlayers[i];
+
+		if (PlayerIndex != INDEX_NONE && EnumHasAnyFlags(Teams[i], ECombatTeam::Enemy) && TargetDistances[i] < AggroRadius)
+		{
+			const FVector ToPlayer = (Players[PlayerIndex].Location - Location).GetSafeNormal2D();
+			Yaws[i] = ToPlayer.Rotation().Yaw;
+
+			if (TargetDistances[i] > AttackRange)
+			{
+				Seek = ToPlayer;
+			}
+		}
+
+		// move along the combined steering direction
+		const FVector Steering = Seek + Separation;
+
+		if (!Steering.IsNearlyZero())
+		{
+			Location += Steering.GetClampedToMaxSize(1.0f) * MoveSpeed * DeltaTime;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_CombatCrowdProxies, NumProxies);
+}
+
+void ACombatCrowd::UpdateGround()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdGround);
+
+	UWorld* World = GetWorld();
+
+	// resolve the checks issued last frame
+	for (int32 i = GroundChecks.Num() - 1; i >= 0; --i)
+	{
+		const FCombatCrowdGroundCheck& Check = GroundChecks[i];
+
+		FTraceDatum WallDatum;
+		FTraceDatum GroundDatum;
+
+		// keep waiting on checks that haven't finished yet
+		if (!World->QueryTraceData(Check.WallTrace, WallDatum) || !World->QueryTraceData(Check.GroundTrace, GroundDatum))
+		{
+			continue;
+		}
+
+		const int32 Agent = Check.Agent;
+
+		// skip agents that were promoted or died while the check was running
+		if (States.IsValidIndex(Agent) && States[Agent] == ECombatCrowdAgentState::Proxy)
+		{
+			const bool bHitWall = WallDatum.OutHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+
+			const FHitResult* GroundHit = GroundDatum.OutHits.FindByPredicate([](const FHitResult& Hit)
+			{
+				return Hit.bBlockingHit && !Hit.bStartPenetrating && Hit.ImpactNormal.Z >= UE_INV_SQRT_2;
+			});
+
+			if (bHitWall || !GroundHit)
+			{
+				// the agent walked into a wall or off a ledge, send it back to where it last stood
+				Locations[Agent] = GroundedLocations[Agent];
+			}
+			else
+			{
+				// stand on the ground, and remember this spot in case the agent gets stuck later
+				Locations[Agent].Z = GroundHit->ImpactPoint.Z;
+				GroundedLocations[Agent] = FVector(Check.Location.X, Check.Location.Y, GroundHit->ImpactPoint.Z);
+			}
+		}
+
+		GroundChecks.RemoveAtSwap(i, EAllowShrinking::No);
+	}
+
+	// check the next slice of agents. Walls are found by sweeping from the last grounded location above step height,
+	// the ground by tracing down from above step height to the maximum drop
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatCrowdGround), false, this);
+	const FCollisionShape WallShape = FCollisionShape::MakeSphere(AgentRadius);
+	const FVector WallOffset(0.0f, 0.0f, MaxStepHeight + AgentRadius);
+
+	const int32 NumToCheck = FMath::Min(GroundChecksPerFrame, Locations.Num());
+
+	for (int32 Checked = 0; Checked < NumToCheck; ++Checked)
+	{
+		NextGroundCheckAgent = NextGroundCheckAgent < Locations.Num() ? NextGroundCheckAgent : 0;
+		const int32 Agent = NextGroundCheckAgent++;
+
+		if (States[Agent] != ECombatCrowdAgentState::Proxy)
+		{
+			continue;
+		}
+
+		FCombatCrowdGroundCheck& Check = GroundChecks.AddDefaulted_GetRef();
+		Check.Agent = Agent;
+		Check.Location = Locations[Agent];
+		Check.WallTrace = World->AsyncSweepByChannel(EAsyncTraceType::Single, GroundedLocations[Agent] + WallOffset, Check.Location + WallOffset, FQuat::Identity, ECC_WorldStatic, WallShape, QueryParams);
+		Check.GroundTrace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Check.Location + FVector(0.0f, 0.0f, MaxStepHeight), Check.Location - FVector(0.0f, 0.0f, MaxDropHeight), ECC_WorldStatic, QueryParams);
+	}
+}
+
+void ACombatCrowd::UpdateAttacks(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdAttacks);
+
+	const TConstArrayView<FACFPlayerSnapshot> Players = GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->GetPlayers();
+	UCombatDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UCombatDamageQueueSubsystem>();
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		if (States[i] != ECombatCrowdAgentState::Proxy || !EnumHasAnyFlags(Teams[i], ECombatTeam::Enemy))
+		{
+			continue;
+		}
+
+		AttackCooldowns[i] = FMath::Max(AttackCooldowns[i] - DeltaTime, 0.0f);
+
+		// hit the closest player if it's in range and we're ready
+		const int32 PlayerIndex = TargetPlayers[i];
+
+		if (PlayerIndex == INDEX_NONE || TargetDistances[i] > AttackRange || AttackCooldowns[i] > 0.0f)
+		{
+			continue;
+		}
+
+		const FACFPlayerSnapshot& Player = Players[PlayerIndex];
+		const FVector Direction = (Player.Location - Locations[i]).GetSafeNormal2D();
+
+		DamageQueue->QueueDamage(Player.Pawn, AttackDamage, this, Player.Location, Direction * AttackImpulse);
+
+		AttackCooldowns[i] = AttackInterval;
+	}
+}
+
+void ACombatCrowd::UpdatePromotion()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdPromotion);
+
+	UACFPlayerInfoSubsystem* PlayerInfo = GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>();
+
+	// demote living enemies that got far from every player and aren't in the middle of an attack
+	for (int32 i = PromotedEnemies.Num() - 1; i >= 0; --i)
+	{
+		const ACombatEnemy* Enemy = PromotedEnemies[i];
+
+		// forget enemies destroyed behind our back, along with their agents
+		if (!IsValid(Enemy))
+		{
+			States[PromotedAgents[i]] = ECombatCrowdAgentState::Dead;
+			PromotedEnemies.RemoveAtSwap(i);
+			PromotedAgents.RemoveAtSwap(i);
+			continue;
+		}
+
+		if (Enemy->CurrentHP <= 0.0f || Enemy->IsAttacking())
+		{
+			continue;
+		}
+
+		float Distance = 0.0f;
+
+		if (PlayerInfo->FindNearestPlayer(Enemy->GetActorLocation(), Distance) && Distance > DemotionRadius)
+		{
+			DemoteEnemy(i);
+		}
+	}
+
+	// promote agents within range while we have room. Each attempt sweeps for a spot, so cap them per frame in case agents are boxed in
+	int32 NumAttempts = 0;
+
+	for (int32 i = 0; i < Locations.Num() && PromotedEnemies.Num() < MaxPromotedEnemies && NumAttempts < MaxPromotedEnemies; ++i)
+	{
+		if (States[i] == ECombatCrowdAgentState::Proxy && TargetDistances[i] < PromotionRadius)
+		{
+			++NumAttempts;
+
+			if (!PromoteAgent(i))
+			{
+				break;
+			}
+		}
+	}
+}
+
+void ACombatCrowd::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdInstances);
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		// collapse the instances of agents that aren't proxies
+		const FVector Scale = States[i] == ECombatCrowdAgentState::Proxy ? FVector::OneVector : FVector::ZeroVector;
+		InstanceTransforms[i] = FTransform(FRotator(0.0f, Yaws[i], 0.0f), Locations[i], Scale);
+	}
+
+	// upload every instance in one batch
+	CrowdMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
+
+void ACombatCrowd::UpdateSnapshot(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdReplication);
+
+	// nobody to send the snapshot to
+	if (GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	SnapshotTimeLeft -= DeltaTime;
+
+	if (SnapshotTimeLeft > 0.0f)
+	{
+		return;
+	}
+
+	SnapshotTimeLeft = SnapshotInterval;
+
+	// copy the agents relative to the actor, so the packed locations stay small
+	const int32 NumAgents = FMath::Min(Locations.Num(), FCombatCrowdSnapshot::MaxAgents);
+	const FVector Origin = GetActorLocation();
+
+	Snapshot.Locations.SetNumUninitialized(NumAgents);
+	Snapshot.Yaws.SetNumUninitialized(NumAgents);
+	Snapshot.States.SetNumUninitialized(NumAgents);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		Snapshot.Locations[i] = Locations[i] - Origin;
+		Snapshot.Yaws[i] = Yaws[i];
+		Snapshot.States[i] = States[i];
+	}
+
+	++Snapshot.Revision;
+}
+
+void ACombatCrowd::UpdateClientAgents(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatCrowdReplication);
+
+	// cover the distance to the snapshot over one snapshot interval, so agents keep moving smoothly between snapshots
+	const float Alpha = FMath::Min(DeltaTime / SnapshotInterval, 1.0f);
+	const FVector Origin = GetActorLocation();
+
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		if (States[i] != ECombatCrowdAgentState::Proxy)
+		{
+			continue;
+		}
+
+		Locations[i] = FMath::Lerp(Locations[i], Origin + Snapshot.Locations[i], Alpha);
+		Yaws[i] = FRotator::NormalizeAxis(Yaws[i] + FRotator::NormalizeAxis(Snapshot.Yaws[i] - Yaws[i]) * Alpha);
+	}
+}
+
+void ACombatCrowd::OnRep_Snapshot()
+{
+	// BeginPlay takes in the initial snapshot instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	const int32 NumAgents = Snapshot.States.Num();
+	const FVector Origin = GetActorLocation();
+
+	// the first snapshot creates the instances
+	if (Locations.Num() != NumAgents)
+	{
+		Locations.SetNumUninitialized(NumAgents);
+		Yaws.SetNumUninitialized(NumAgents);
+		States.Init(ECombatCrowdAgentState::Dead, NumAgents);
+		InstanceTransforms.SetNumUninitialized(NumAgents);
+
+		for (int32 i = 0; i < NumAgents; ++i)
+		{
+			InstanceTransforms[i] = FTransform(FRotator::ZeroRotator, Origin, FVector::ZeroVector);
+		}
+
+		CrowdMesh->ClearInstances();
+		CrowdMesh->AddInstances(InstanceTransforms, false, true);
+	}
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		// agents that just became proxies appear where the server has them instead of sliding in from their old spot
+		if (Snapshot.States[i] == ECombatCrowdAgentState::Proxy && States[i] != ECombatCrowdAgentState::Proxy)
+		{
+			Locations[i] = Origin + Snapshot.Locations[i];
+			Yaws[i] = Snapshot.Yaws[i];
+		}
+
+		States[i] = Snapshot.States[i];
+	}
+}
+
+bool ACombatCrowd::PromoteAgent(int32 AgentIndex)
+{
+	ACombatEnemy* Enemy = GetPooledEnemy();
+
+	if (!Enemy)
+	{
+		return false;
+	}
+
+	// sweep the enemy's capsule down onto the spot where the agent is standing, so it doesn't end up inside a wall or another pawn
+	const UCapsuleComponent* Capsule = Enemy->GetCapsuleComponent();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	const FVector SweepStart = Locations[AgentIndex] + FVector(0.0f, 0.0f, HalfHeight + MaxStepHeight);
+	const FVector SweepEnd = Locations[AgentIndex] + FVector(0.0f, 0.0f, HalfHeight - MaxStepHeight);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatCrowdPromotion), false, this);
+	QueryParams.AddIgnoredActor(Enemy);
+
+	FHitResult PlacementHit;
+	GetWorld()->SweepSingleByChannel(PlacementHit, SweepStart, SweepEnd, FQuat::Identity, Capsule->GetCollisionObjectType(), Capsule->GetCollisionShape(), QueryParams, FCollisionResponseParams(Capsule->GetCollisionResponseToChannels()));
+
+	// there's no room here, leave the agent as a proxy and try again once it has moved
+	if (PlacementHit.bStartPenetrating)
+	{
+		EnemyPool.Add(Enemy);
+		return true;
+	}
+
+	// bring the enemy in where it landed, with the agent's HP
+	const FVector SpawnLocation = PlacementHit.bBlockingHit ? PlacementHit.Location : SweepEnd;
+	Enemy->ResetForReuse(FTransform(FRotator(0.0f, Yaws[AgentIndex], 0.0f), SpawnLocation));
+	Enemy->SetHP(HPs[AgentIndex]);
+
+	States[AgentIndex] = ECombatCrowdAgentState::Promoted;
+	PromotedEnemies.Add(Enemy);
+	PromotedAgents.Add(AgentIndex);
+
+	return true;
+}
+
+void ACombatCrowd::DemoteEnemy(int32 PromotedIndex)
+{
+	ACombatEnemy* Enemy = PromotedEnemies[PromotedIndex];
+	const int32 AgentIndex = PromotedAgents[PromotedIndex];
+
+	// carry the enemy's state back to the agent
+	const float HalfHeight = Enemy->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	Locations[AgentIndex] = Enemy->GetActorLocation() - FVector(0.0f, 0.0f, HalfHeight);
+	GroundedLocations[AgentIndex] = Locations[AgentIndex];
+	Yaws[AgentIndex] = Enemy->GetActorRotation().Yaw;
+	HPs[AgentIndex] = Enemy->CurrentHP;
+	AttackCooldowns[AgentIndex] = AttackInterval;
+	States[AgentIndex] = ECombatCrowdAgentState::Proxy;
+
+	// put the enemy back in the pool
+	Enemy->DeactivateForPool();
+	EnemyPool.Add(Enemy);
+
+	PromotedEnemies.RemoveAtSwap(PromotedIndex);
+	PromotedAgents.RemoveAtSwap(PromotedIndex);
+}
+
+ACombatEnemy* ACombatCrowd::GetPooledEnemy()
+{
+	// reuse a pooled enemy if we have one
+	if (!EnemyPool.IsEmpty())
+	{
+		return EnemyPool.Pop(EAllowShrinking::No);
+	}
+
+	// ensure the enemy class is valid
+	if (!IsValid(EnemyClass))
+	{
+		return nullptr;
+	}
+
+	// otherwise create a new one
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ACombatEnemy* SpawnedEnemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, GetActorTransform(), SpawnParams);
+
+	// ask the enemy to come back to us instead of being destroyed
+	if (SpawnedEnemy)
+	{
+		SpawnedEnemy->OnEnemyRemovedFromLevel.BindUObject(this, &ACombatCrowd::OnPromotedEnemyRemoved);
+	}
+
+	return SpawnedEnemy;
+}
+
+void ACombatCrowd::OnPromotedEnemyRemoved(ACombatEnemy* Enemy)
+{
+	const int32 PromotedIndex = PromotedEnemies.IndexOfByKey(Enemy);
+
+	if (PromotedIndex != INDEX_NONE)
+	{
+		// the agent died as a full enemy
+		const int32 AgentIndex = PromotedAgents[PromotedIndex];
+		States[AgentIndex] = ECombatCrowdAgentState::Dead;
+		HPs[AgentIndex] = 0.0f;
+
+		PromotedEnemies.RemoveAtSwap(PromotedIndex);
+		PromotedAgents.RemoveAtSwap(PromotedIndex);
+	}
+
+	// the enemy already deactivated itself, make it available for the next promotion
+	EnemyPool.Add(Enemy);
+}
+
+FIntPoint ACombatCrowd::GetGridCell(const FVector& Location) const
+{
+	const float CellSize = FMath::Max(SeparationRadius, 1.0f);
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
@@ -0,0 +1,316 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatCrowd.generated.h"
+
+class UInstancedStaticMeshComponent;
+class ACombatEnemy;
+
+DECLARE_STATS_GROUP(TEXT("CombatCrowd"), STATGROUP_CombatCrowd, STATCAT_Advanced);
+
+/**
+ *  Lifecycle state of a crowd agent
+ */
+enum class ECombatCrowdAgentState : uint8
+{
+	/** Simulated by the crowd and drawn as an instance */
+	Proxy,
+
+	/** Represented by a full enemy actor */
+	Promoted,
+
+	/** Dead, no longer simulated or drawn */
+	Dead
+};
+
+/**
+ *  Compact copy of the agents sent to clients so they can draw the crowd
+ */
+USTRUCT()
+struct FCombatCrowdSnapshot
+{
+	GENERATED_BODY()
+
+	/** Largest crowd a client will accept. Agents past this are only simulated on the server */
+	static constexpr int32 MaxAgents = 4096;
+
+	/** Bumped by the server every time it refreshes the snapshot, so the snapshot only replicates when it changes */
+	UPROPERTY()
+	int32 Revision = 0;
+
+	/** Agent locations, relative to the crowd actor */
+	TArray<FVector> Locations;
+
+	/** Agent facing, in degrees */
+	TArray<float> Yaws;
+
+	/** Agent lifecycle states */
+	TArray<ECombatCrowdAgentState> States;
+
+	/** Bit-packs the agent count followed by each agent's state, and the location and facing of proxies */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** Snapshots are compared by revision instead of by every agent */
+	bool Identical(const FCombatCrowdSnapshot* Other, uint32 PortFlags) const { return Revision == Other->Revision; }
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatCrowdSnapshot> : public TStructOpsTypeTraitsBase2<FCombatCrowdSnapshot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true
+	};
+};
+
+/**
+ *  An in-flight check of an agent against the level
+ */
+struct FCombatCrowdGroundCheck
+{
+	/** Agent being checked */
+	int32 Agent = INDEX_NONE;
+
+	/** Agent location when the check was issued */
+	FVector Location = FVector::ZeroVector;
+
+	/** Sweep from the last grounded location to the checked location, blocked by walls */
+	FTraceHandle WallTrace;
+
+	/** Trace down from the checked location, finds the ground */
+	FTraceHandle GroundTrace;
+};
+
+/**
+ *  A large crowd of combat enemies simulated as lightweight agents.
+ *  Agent data is kept in parallel arrays and updated in a few tight passes: steering towards the closest player,
+ *  simple attack timing, promotion and instance transforms. Agents are drawn through a single instanced mesh.
+ *  Agents that get close to a player are promoted to pooled full enemy actors, and demoted back to agents when they get far again,
+ *  so only a handful of full characters exist at once no matter how big the crowd is.
+ *  The crowd is simulated on the server. Clients receive a periodic snapshot of the agents and only draw them
+ */
+UCLASS(abstract)
+class ACombatCrowd : public AActor
+{
+	GENERATED_BODY()
+
+	/** Draws every proxy agent */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components, meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* CrowdMesh;
+
+protected:
+
+	/** Enemy class agents are promoted to */
+	UPROPERTY(EditAnywhere, Category="Crowd")
+	TSubclassOf<ACombatEnemy> EnemyClass;
+
+	/** Number of agents to create on BeginPlay */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 10000))
+	int32 CrowdSize = 500;
+
+	/** Agents are scattered within this radius around the actor */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, Units = "cm"))
+	float SpawnRadius = 5000.0f;
+
+	/** Team agents belong to. Only enemy agents chase and attack players */
+	UPROPERTY(EditAnywhere, Category="Crowd")
+	ECombatTeam AgentTeam = ECombatTeam::Enemy;
+
+	/** HP agents start with */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0))
+	float AgentMaxHP = 3.0f;
+
+	/** Agent walk speed */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm/s"))
+	float MoveSpeed = 300.0f;
+
+	/** Agents further than this from every player stand still */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm"))
+	float AggroRadius = 8000.0f;
+
+	/** Agents try to keep at least this much space between each other */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm"))
+	float SeparationRadius = 100.0f;
+
+	/** Agents step up and down ledges up to this height. Taller obstacles block them */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm"))
+	float MaxStepHeight = 45.0f;
+
+	/** Agents with no ground within this distance below them stop at the edge */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm"))
+	float MaxDropHeight = 150.0f;
+
+	/** Radius used to stop agents at walls */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 0, Units = "cm"))
+	float AgentRadius = 35.0f;
+
+	/** Number of agents checked against walls and ground each frame. Checks are asynchronous and resolve on the next frame */
+	UPROPERTY(EditAnywhere, Category="Crowd|Movement", meta = (ClampMin = 1))
+	int32 GroundChecksPerFrame = 64;
+
+	/** Agents closer than this to a player stop and attack */
+	UPROPERTY(EditAnywhere, Category="Crowd|Attack", meta = (ClampMin = 0, Units = "cm"))
+	float AttackRange = 150.0f;
+
+	/** Time between agent attacks */
+	UPROPERTY(EditAnywhere, Category="Crowd|Attack", meta = (ClampMin = 0, Units = "s"))
+	float AttackInterval = 2.0f;
+
+	/** Damage dealt by an agent attack */
+	UPROPERTY(EditAnywhere, Category="Crowd|Attack", meta = (ClampMin = 0))
+	float AttackDamage = 1.0f;
+
+	/** Knockback impulse applied by an agent attack */
+	UPROPERTY(EditAnywhere, Category="Crowd|Attack", meta = (ClampMin = 0, Units = "cm/s"))
+	float AttackImpulse = 150.0f;
+
+	/** Agents closer than this to a player are promoted to full enemies */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, Units = "cm"))
+	float PromotionRadius = 2500.0f;
+
+	/** Promoted enemies further than this from every player are demoted back to agents. Larger than the promotion radius to avoid flickering */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, Units = "cm"))
+	float DemotionRadius = 3000.0f;
+
+	/** Maximum number of promoted enemies at once */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, ClampMax = 100))
+	int32 MaxPromotedEnemies = 16;
+
+	/** Time between agent snapshots sent to clients */
+	UPROPERTY(EditAnywhere, Category="Crowd|Replication", meta = (ClampMin = 0.05, Units = "s"))
+	float SnapshotInterval = 0.25f;
+
+	/** Latest agent snapshot. Refreshed by the server, drawn by clients */
+	UPROPERTY(ReplicatedUsing = OnRep_Snapshot)
+	FCombatCrowdSnapshot Snapshot;
+
+	/** Time left until the server refreshes the snapshot */
+	float SnapshotTimeLeft = 0.0f;
+
+	/** Agent locations */
+	TArray<FVector> Locations;
+
+	/** Last location each agent was confirmed to be standing on the ground */
+	TArray<FVector> GroundedLocations;
+
+	/** Agent facing, in degrees */
+	TArray<float> Yaws;
+
+	/** Agent HP */
+	TArray<float> HPs;
+
+	/** Agent teams */
+	TArray<ECombatTeam> Teams;
+
+	/** Time left until each agent can attack again */
+	TArray<float> AttackCooldowns;
+
+	/** Agent lifecycle states */
+	TArray<ECombatCrowdAgentState> States;
+
+	/** Closest player to each agent, refreshed every frame */
+	TArray<int32> TargetPlayers;
+
+	/** Distance to the closest player for each agent, refreshed every frame */
+	TArray<float> TargetDistances;
+
+	/** Promoted enemies and the agents they represent */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatEnemy>> PromotedEnemies;
+	TArray<int32> PromotedAgents;
+
+	/** Inactive enemies waiting to be used for promotion */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatEnemy>> EnemyPool;
+
+	/** Wall and ground checks waiting for their results */
+	TArray<FCombatCrowdGroundCheck> GroundChecks;
+
+	/** Next agent to check against the level */
+	int32 NextGroundCheckAgent = 0;
+
+	/** Separation grid. Maps each cell to the first agent in it, agents in the same cell are chained through GridNext */
+	TMap<FIntPoint, int32> GridHeads;
+	TArray<int32> GridNext;
+
+	/** Scratch instance transforms, uploaded in one batch every frame */
+	TArray<FTransform> InstanceTransforms;
+
+public:
+
+	/** Constructor */
+	ACombatCrowd();
+
+	/** Returns the number of agents still alive */
+	int32 GetNumLiveAgents() const;
+
+protected:
+
+	/** Creates the agents */
+	virtual void BeginPlay() override;
+
+	/** Destroys the pooled enemies */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	/** Runs the crowd passes on the server, and moves the drawn agents towards the latest snapshot on clients */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Sets up the replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+
+	/** Finds the closest player to every agent */
+	void UpdateTargets();
+
+	/** Rebuilds the separation grid */
+	void UpdateGrid();
+
+	/** Steers proxy agents towards their closest player while keeping them apart */
+	void UpdateMovement(float DeltaTime);
+
+	/** Resolves last frame's wall and ground checks and issues the next batch */
+	void UpdateGround();
+
+	/** Counts down attack cooldowns and attacks players in range */
+	void UpdateAttacks(float DeltaTime);
+
+	/** Promotes agents close to players and demotes promoted enemies that got far */
+	void UpdatePromotion();
+
+	/** Uploads the proxy instance transforms */
+	void UpdateInstances();
+
+	/** Copies the agents into the replicated snapshot every snapshot interval */
+	void UpdateSnapshot(float DeltaTime);
+
+	/** Moves the client's agents towards the latest snapshot */
+	void UpdateClientAgents(float DeltaTime);
+
+	/** Takes in a new snapshot on clients */
+	UFUNCTION()
+	void OnRep_Snapshot();
+
+	/** Replaces the agent with a full enemy, if there's room for it where the agent stands. Returns false if there's no enemy available */
+	bool PromoteAgent(int32 AgentIndex);
+
+	/** Replaces the promoted enemy with its agent again */
+	void DemoteEnemy(int32 PromotedIndex);
+
+	/** Returns an inactive enemy from the pool, creating one if needed */
+	ACombatEnemy* GetPooledEnemy();
+
+	/** Called when a promoted enemy is removed from the level after dying */
+	void OnPromotedEnemyRemoved(ACombatEnemy* Enemy);
+
+	/** Returns the separation grid cell for a location */
+	FIntPoint GetGridCell(const FVector& Location) const;
+};
@@ -0,0 +1,203 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatEQSSubsystem.h"
+#include "EnvironmentQuery/EnvQuery.h"
+#include "EnvironmentQuery/EnvQueryManager.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Run Combat EQS Queries"), STAT_CombatEQSRunQueries, STATGROUP_CombatEQS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queries Run"), STAT_CombatEQSQueriesRun, STATGROUP_CombatEQS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Results Reused"), STAT_CombatEQSResultsReused, STATGROUP_CombatEQS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Requests"), STAT_CombatEQSQueuedRequests, STATGROUP_CombatEQS);
+
+int32 UCombatEQSSubsystem::RequestQuery(UEnvQuery* Query, AActor* Querier, AActor* Target, bool bShareResults)
+{
+	FCombatEQSRequest Request;
+	Request.RequestId = NextRequestId++;
+	Request.Query = Query;
+	Request.Querier = Querier;
+	Request.Target = Target;
+	Request.bShareResults = bShareResults && Target;
+
+	// serve the request right away if another enemy recently ran the same query
+	if (!Request.bShareResults || !TryServeSharedResult(Request))
+	{
+		Queue.Add(Request);
+		Results.Add(Request.RequestId);
+	}
+
+	return Request.RequestId;
+}
+
+ECombatEQSRequestStatus UCombatEQSSubsystem::ConsumeResult(int32 RequestId, FVector& OutLocation)
+{
+	const FCombatEQSRequestResult* Result = Results.Find(RequestId);
+
+	// unknown requests were either cancelled or already consumed
+	if (!Result)
+	{
+		return ECombatEQSRequestStatus::Failed;
+	}
+
+	const ECombatEQSRequestStatus Status = Result->Status;
+
+	if (Status != ECombatEQSRequestStatus::Pending)
+	{
+		OutLocation = Result->Location;
+		Results.Remove(RequestId);
+	}
+
+	return Status;
+}
+
+void UCombatEQSSubsystem::CancelRequest(int32 RequestId)
+{
+	Queue.RemoveAll([RequestId](const FCombatEQSRequest& Request) { return Request.RequestId == RequestId; });
+	Results.Remove(RequestId);
+}
+
+void UCombatEQSSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatEQSRunQueries);
+
+	INC_DWORD_STAT_BY(STAT_CombatEQSQueuedRequests, Queue.Num());
+
+	// forget shared results that are too old to be reused
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (auto It = SharedResults.CreateIterator(); It; ++It)
+	{
+		if (CurrentTime - It.Value().Time > SharedResultLifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// run requests in order until the budget is spent, but always make some progress
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = FrameBudgetMs * 0.001;
+
+	int32 NumProcessed = 0;
+	bool bRanQuery = false;
+
+	while (NumProcessed < Queue.Num())
+	{
+		const FCombatEQSRequest Request = Queue[NumProcessed];
+
+		// shared results are nearly free, so they don't count against the budget
+		if (Request.bShareResults && TryServeSharedResult(Request))
+		{
+			++NumProcessed;
+			continue;
+		}
+
+		if (bRanQuery && FPlatformTime::Seconds() - StartTime >= Budget)
+		{
+			break;
+		}
+
+		RunRequest(Request);
+
+		bRanQuery = true;
+		++NumProcessed;
+	}
+
+	Queue.RemoveAt(0, NumProcessed, EAllowShrinking::No);
+}
+
+TStatId UCombatEQSSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatEQSSubsystem, STATGROUP_Tickables);
+}
+
+bool UCombatEQSSubsystem::TryServeSharedResult(const FCombatEQSRequest& Request)
+{
+	const AActor* Target = Request.Target.Get();
+
+	if (!Target)
+	{
+		return false;
+	}
+
+	FCombatEQSSharedResult* SharedResult = SharedResults.Find(MakeTuple(TObjectKey<UEnvQuery>(Request.Query.Get()), TObjectKey<AActor>(Target)));
+
+	if (!SharedResult || SharedResult->Locations.IsEmpty())
+	{
+		return false;
+	}
+
+	// is the result still fresh and close to where the target is now?
+	if (GetWorld()->GetTimeSeconds() - SharedResult->Time > SharedResultLifetime
+		|| FVector::DistSquared(SharedResult->TargetLocation, Target->GetActorLocation()) > FMath::Square(SharedResultMaxTargetMove))
+	{
+		return false;
+	}
+
+	// hand out the next best location so enemies sharing the result don't all pick the same spot
+	const FVector& Location = SharedResult->Locations[SharedResult->NextLocation % SharedResult->Locations.Num()];
+	++SharedResult->NextLocation;
+
+	FinishRequest(Request.RequestId, ECombatEQSRequestStatus::Succeeded, Location);
+
+	INC_DWORD_STAT(STAT_CombatEQSResultsReused);
+
+	return true;
+}
+
+void UCombatEQSSubsystem::RunRequest(const FCombatEQSRequest& Request)
+{
+	UEnvQuery* Query = Request.Query.Get();
+	AActor* Querier = Request.Querier.Get();
+	UEnvQueryManager* QueryManager = UEnvQueryManager::GetCurrent(GetWorld());
+
+	if (!Query || !Querier || !QueryManager)
+	{
+		FinishRequest(Request.RequestId, ECombatEQSRequestStatus::Failed);
+		return;
+	}
+
+	// provide the request's target to the query through UEnvQueryContext_CombatTarget, so the result matches the target it's shared for
+	TGuardValue<TWeakObjectPtr<AActor>> TargetGuard(RunningTarget, Request.Target);
+
+	// shared queries keep every matching item so each enemy can get its own location
+	FEnvQueryRequest QueryRequest(Query, Querier);
+	const TSharedPtr<FEnvQueryResult> QueryResult = QueryManager->RunInstantQuery(QueryRequest, Request.bShareResults ? EEnvQueryRunMode::AllMatching : EEnvQueryRunMode::SingleResult);
+
+	INC_DWORD_STAT(STAT_CombatEQSQueriesRun);
+
+	if (!QueryResult.IsValid() || !QueryResult->IsSuccessful() || QueryResult->Items.IsEmpty())
+	{
+		FinishRequest(Request.RequestId, ECombatEQSRequestStatus::Failed);
+		return;
+	}
+
+	const AActor* Target = Request.Target.Get();
+
+	if (Request.bShareResults && Target)
+	{
+		// store the best locations for the other enemies positioning around this target
+		FCombatEQSSharedResult& SharedResult = SharedResults.FindOrAdd(MakeTuple(TObjectKey<UEnvQuery>(Query), TObjectKey<AActor>(Target)));
+		SharedResult.Locations.Reset();
+		SharedResult.TargetLocation = Target->GetActorLocation();
+		SharedResult.Time = GetWorld()->GetTimeSeconds();
+		SharedResult.NextLocation = 1;
+
+		const int32 NumLocations = FMath::Min(QueryResult->Items.Num(), MaxSharedLocations);
+
+		for (int32 i = 0; i < NumLocations; ++i)
+		{
+			SharedResult.Locations.Add(QueryResult->GetItemAsLocation(i));
+		}
+	}
+
+	// the requester gets the best location
+	FinishRequest(Request.RequestId, ECombatEQSRequestStatus::Succeeded, QueryResult->GetItemAsLocation(0));
+}
+
+void UCombatEQSSubsystem::FinishRequest(int32 RequestId, ECombatEQSRequestStatus Status, const FVector& Location)
+{
+	FCombatEQSRequestResult& Result = Results.FindOrAdd(RequestId);
+	Result.Status = Status;
+	Result.Location = Location;
+}
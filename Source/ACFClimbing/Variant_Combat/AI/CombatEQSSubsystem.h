@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CombatEQSSubsystem.generated.h"
+
+class UEnvQuery;
+
+DECLARE_STATS_GROUP(TEXT("CombatEQS"), STATGROUP_CombatEQS, STATCAT_Advanced);
+
+/**
+ *  State of a scheduled combat EQS request
+ */
+enum class ECombatEQSRequestStatus : uint8
+{
+	Pending,
+	Succeeded,
+	Failed
+};
+
+/**
+ *  An EQS request waiting for budget
+ */
+struct FCombatEQSRequest
+{
+	/** Id handed back to the requester */
+	int32 RequestId = INDEX_NONE;
+
+	/** Query to run */
+	TWeakObjectPtr<UEnvQuery> Query;
+
+	/** Actor running the query */
+	TWeakObjectPtr<AActor> Querier;
+
+	/** Actor the query positions around, provided by UEnvQueryContext_CombatTarget. Requests with the same query and target can share results */
+	TWeakObjectPtr<AActor> Target;
+
+	/** If true, the result can be served from, and stored into, the shared result cache */
+	bool bShareResults = false;
+};
+
+/**
+ *  A finished EQS request, waiting to be picked up by the requester
+ */
+struct FCombatEQSRequestResult
+{
+	/** Request outcome */
+	ECombatEQSRequestStatus Status = ECombatEQSRequestStatus::Pending;
+
+	/** Chosen location */
+	FVector Location = FVector::ZeroVector;
+};
+
+/**
+ *  Query results shared by every enemy positioning around the same target
+ */
+struct FCombatEQSSharedResult
+{
+	/** Best scoring locations, in descending score order */
+	TArray<FVector> Locations;
+
+	/** Target location when the query ran */
+	FVector TargetLocation = FVector::ZeroVector;
+
+	/** World time the query ran at */
+	float Time = 0.0f;
+
+	/** Next location to hand out, so enemies sharing the result spread out */
+	int32 NextLocation = 0;
+};
+
+/**
+ *  Runs combat EQS queries under a per-frame time budget.
+ *  Requests are queued and run in order until the budget is spent, so many enemies asking for a position at once
+ *  are spread over several frames. Results for the same query and target are reused for a short time,
+ *  handing each enemy a different location from the shared result
+ */
+UCLASS()
+class UCombatEQSSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Time budget for running queries each frame, in milliseconds. At least one query runs every frame */
+	float FrameBudgetMs = 1.0f;
+
+	/** Time a shared result can be reused for */
+	float SharedResultLifetime = 0.5f;
+
+	/** Shared results are discarded if their target moved further than this since the query ran */
+	float SharedResultMaxTargetMove = 200.0f;
+
+	/** Maximum number of locations kept from a shared result */
+	int32 MaxSharedLocations = 16;
+
+	/** Id for the next request */
+	int32 NextRequestId = 0;
+
+	/** Requests waiting for budget, in the order they were made */
+	TArray<FCombatEQSRequest> Queue;
+
+	/** Finished requests waiting to be picked up */
+	TMap<int32, FCombatEQSRequestResult> Results;
+
+	/** Shared results, per query and target */
+	TMap<TPair<TObjectKey<UEnvQuery>, TObjectKey<AActor>>, FCombatEQSSharedResult> SharedResults;
+
+	/** Target of the request being run, while its query runs */
+	TWeakObjectPtr<AActor> RunningTarget;
+
+public:
+
+	/**
+	 *  Schedules an EQS query for the querier and returns its request id.
+	 *  If bShareResults is set and a recent result exists for the same query and target, the request finishes right away
+	 */
+	int32 RequestQuery(UEnvQuery* Query, AActor* Querier, AActor* Target, bool bShareResults);
+
+	/** Returns the request status, and the chosen location once it succeeded. Finished requests are forgotten once read */
+	ECombatEQSRequestStatus ConsumeResult(int32 RequestId, FVector& OutLocation);
+
+	/** Drops a request that's no longer needed */
+	void CancelRequest(int32 RequestId);
+
+	/** Returns the target of the request whose query is running, for UEnvQueryContext_CombatTarget */
+	AActor* GetRunningTarget() const { return RunningTarget.Get(); }
+
+	// ~begin FTickableGameObject interface
+
+	/** Runs queued requests until the frame budget is spent */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+
+protected:
+
+	/** Finishes the request from a recent shared result. Returns false if there isn't a usable one */
+	bool TryServeSharedResult(const FCombatEQSRequest& Request);
+
+	/** Runs the query right away and finishes the request */
+	void RunRequest(const FCombatEQSRequest& Request);
+
+	/** Stores the outcome of a request */
+	void FinishRequest(int32 RequestId, ECombatEQSRequestStatus Status, const FVector& Location = FVector::ZeroVector);
+};
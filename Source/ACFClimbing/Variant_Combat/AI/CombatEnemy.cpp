@@ -11,6 +11,16 @@
 #include "TimerManager.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatAttackTrajectories.h"
+#include "CombatAttackSet.h"
+#include "CombatLifeBarSubsystem.h"
+#include "CombatRagdollSubsystem.h"
+#include "BrainComponent.h"
+#include "CombatEventSubsystem.h"
+#include "CombatAILODSubsystem.h"
+#include "CombatAttackTokenSubsystem.h"
+#include "Net/UnrealNetwork.h"
 
 ACombatEnemy::ACombatEnemy()
 {
@@ -54,7 +64,7 @@ void ACombatEnemy::DoAIComboAttack()
 	bIsAttacking = true;
 
 	// choose how many times we're going to attack
-	TargetComboCount = FMath::RandRange(1, ComboSectionNames.Num() - 1);
+	TargetComboCount = FMath::RandRange(1, (AttackSet ? AttackSet->GetNumComboAttacks() : ComboSectionNames.Num()) - 1);
 
 	// reset the attack counter
 	CurrentComboAttack = 0;
@@ -69,6 +79,9 @@ void ACombatEnemy::DoAIComboAttack()
 		{
 			// set the end delegate for the montage
 			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
+
+			// play the attack on clients
+			GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackStart(this, 0);
 		}
 	}
 }
@@ -100,6 +113,9 @@ void ACombatEnemy::DoAIChargedAttack()
 		{
 			// set the end delegate for the montage
 			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
+
+			// play the attack on clients
+			GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackStart(this, 1);
 		}
 	}
 }
@@ -109,81 +125,99 @@ void ACombatEnemy::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
 	// reset the attacking flag
 	bIsAttacking = false;
 
-	// call the attack completed delegate so the StateTree can continue execution
-	OnAttackCompleted.ExecuteIfBound();
+	// close any attack window left open by an interrupted montage
+	CurrentSwing.End();
+
+	// count the completed attack so the StateTree can continue execution
+	++AttackCompletedCount;
 }
 
-void ACombatEnemy::DoAttackTrace(FName DamageSourceBone)
+FCombatMeleeSettings ACombatEnemy::GetMeleeSettings() const
 {
-	// sweep for objects in front of the character to be hit by the attack
-	TArray<FHitResult> OutHits;
-
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
-	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+	FCombatMeleeSettings Settings;
+	Settings.AttackSet = AttackSet;
+	Settings.AttackTrajectories = AttackTrajectories;
+	Settings.TraceDistance = MeleeTraceDistance;
+	Settings.TraceRadius = MeleeTraceRadius;
+	Settings.Damage = MeleeDamage;
+	Settings.KnockbackImpulse = MeleeKnockbackImpulse;
+	Settings.LaunchImpulse = MeleeLaunchImpulse;
+
+	// enemies only affect the player team; they don't knock back boxes
+	Settings.TargetTeams = ECombatTeam::Player;
+
+	return Settings;
+}
 
-	// enemies only affect Pawn collision objects; they don't knock back boxes
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+void ACombatEnemy::DoAttackTrace(FName DamageSourceBone)
+{
+	FCombatMelee::DoAttackTrace(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	// use a sphere shape for the sweep
-	FCollisionShape CollisionShape;
-	CollisionShape.SetSphere(MeleeTraceRadius);
+void ACombatEnemy::BeginAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::BeginAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	// ignore self
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
+void ACombatEnemy::TickAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::TickAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	if (GetWorld()->SweepMultiByObjectType(OutHits, TraceStart, TraceEnd, FQuat::Identity, ObjectParams, CollisionShape, QueryParams))
-	{
-		// iterate over each object hit
-		for (const FHitResult& CurrentHit : OutHits)
-		{
-			/** does the actor have the player tag? */
-			if (CurrentHit.GetActor()->ActorHasTag(FName("Player")))
-			{
-				// check if the actor is damageable
-				ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
-
-				if (Damageable)
-				{
-					// knock upwards and away from the impact normal
-					const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
-
-					// pass the damage event to the actor
-					Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
-
-				}
-			}
-		}
-	}
+void ACombatEnemy::EndAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::EndAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
 }
 
 void ACombatEnemy::CheckCombo()
 {
+	// clients follow the server's sections from the combat event stream
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// increase the combo counter
 	++CurrentComboAttack;
 
 	// do we still have attacks to play in this string?
 	if (CurrentComboAttack < TargetComboCount)
 	{
-		// jump to the next attack section
+		// jump to the next attack section. Attack sets already know the section index
 		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 		{
-			AnimInstance->Montage_JumpToSection(ComboSectionNames[CurrentComboAttack], ComboAttackMontage);
+			const int32 SectionIndex = AttackSet ? AttackSet->GetComboAttack(CurrentComboAttack).SectionIndex : ComboAttackMontage->GetSectionIndex(ComboSectionNames[CurrentComboAttack]);
+			UCombatAttackSet::JumpToSection(AnimInstance, ComboAttackMontage, SectionIndex);
+
+			// jump to the same section on clients
+			GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackSection(this, 0, SectionIndex);
 		}
 	}
 }
 
 void ACombatEnemy::CheckChargedAttack()
 {
+	// clients follow the server's sections from the combat event stream
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// increase the charge loop counter
 	++CurrentChargeLoop;
 
 	// jump to either the loop or attack section of the montage depending on whether we hit the loop target
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
-		AnimInstance->Montage_JumpToSection(CurrentChargeLoop >= TargetChargeLoops ? ChargeAttackSection : ChargeLoopSection, ChargedAttackMontage);
+		const bool bReleaseCharge = CurrentChargeLoop >= TargetChargeLoops;
+		const int32 SectionIndex = AttackSet
+			? (bReleaseCharge ? AttackSet->GetChargeAttack().SectionIndex : AttackSet->GetChargeLoopSectionIndex())
+			: ChargedAttackMontage->GetSectionIndex(bReleaseCharge ? ChargeAttackSection : ChargeLoopSection);
+
+		UCombatAttackSet::JumpToSection(AnimInstance, ChargedAttackMontage, SectionIndex);
+
+		// jump to the same section on clients
+		GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackSection(this, 1, SectionIndex);
 	}
 }
 
@@ -197,6 +231,9 @@ void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector
 	// only process knockback and effects if we received nonzero damage
 	if (ActualDamage > 0.0f)
 	{
+		// run the AI at full rate so it can react, even if it was throttled or asleep
+		GetWorld()->GetSubsystem<UCombatAILODSubsystem>()->WakeEnemy(this);
+
 		// apply the knockback impulse
 		GetCharacterMovement()->AddImpulse(DamageImpulse, true);
 
@@ -216,22 +253,28 @@ void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector
 
 		// pass control to BP to play effects, etc.
 		ReceivedDamage(ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
+
+		// play the damage effects on clients
+		GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostDamage(this, ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
 	}
 }
 
 void ACombatEnemy::HandleDeath()
 {
-	// hide the life bar
-	LifeBar->SetHiddenInGame(true);
-
-	// disable the collision capsule to avoid being hit again while dead
-	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-
 	// disable character movement
 	GetCharacterMovement()->DisableMovement();
 
-	// enable full ragdoll physics
-	GetMesh()->SetSimulatePhysics(true);
+	// ragdoll and hide the life bar. Clients play this when they see our HP reach zero
+	PlayDeathEffects();
+
+	// stop being a melee target
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->UnregisterDamageable(this);
+
+	// stop throttling so the death animation and ragdoll play at full rate
+	GetWorld()->GetSubsystem<UCombatAILODSubsystem>()->UnregisterEnemy(this);
+
+	// let other enemies attack in our place
+	GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>()->ReleaseAllTokens(this);
 
 	// call the died delegate to notify any subscribers
 	OnEnemyDied.Broadcast();
@@ -240,17 +283,254 @@ void ACombatEnemy::HandleDeath()
 	GetWorld()->GetTimerManager().SetTimer(DeathTimer, this, &ACombatEnemy::RemoveFromLevel, DeathRemovalTime);
 }
 
+void ACombatEnemy::PlayDeathEffects()
+{
+	bShowingDeathEffects = true;
+
+	// hide the life bar
+	SetLifeBarVisible(false);
+
+	// disable the collision capsule to avoid being hit again while dead
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	// enable full ragdoll physics if the ragdoll budget allows it
+	if (!GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StartRagdoll(GetMesh()))
+	{
+		// over budget, play the canned death animation instead
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			AnimInstance->Montage_Play(DeathMontage);
+		}
+	}
+}
+
 void ACombatEnemy::ApplyHealing(float Healing, AActor* Healer)
 {
 	// stub
 }
 
+void ACombatEnemy::ReceiveCombatEvent(const FCombatEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case ECombatEventType::AttackStart:
+	case ECombatEventType::AttackSection:
+
+		FCombatMelee::PlayAttackEvent(this, Event, ComboAttackMontage, ChargedAttackMontage);
+		break;
+
+	case ECombatEventType::Damage:
+
+		// damage interrupts the attack
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
+			AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
+		}
+
+		ReceivedDamage(Event.Damage, Event.Location, Event.Direction);
+		break;
+
+	default:
+		break;
+	}
+}
+
 void ACombatEnemy::RemoveFromLevel()
 {
+	// is a spawner pooling us?
+	if (OnEnemyRemovedFromLevel.IsBound())
+	{
+		// deactivate and hand ourselves back to the pool
+		DeactivateForPool();
+		OnEnemyRemovedFromLevel.Execute(this);
+		return;
+	}
+
 	// destroy this actor
 	Destroy();
 }
 
+void ACombatEnemy::SetLifeBarPercentage(float Percent)
+{
+	// push the value to whichever life bar we're using
+	if (bUseBatchedLifeBar)
+	{
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->SetLifePercentage(this, Percent);
+	}
+	else
+	{
+		LifeBarWidget->SetLifePercentage(Percent);
+	}
+}
+
+void ACombatEnemy::SetLifeBarVisible(bool bVisible)
+{
+	if (bUseBatchedLifeBar)
+	{
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->SetLifeBarVisible(this, bVisible);
+	}
+	else
+	{
+		LifeBar->SetHiddenInGame(!bVisible);
+	}
+}
+
+void ACombatEnemy::OnRep_CurrentHP()
+{
+	// the initial replication can arrive before BeginPlay sets up the life bar. BeginPlay applies it instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	// clients follow the server's HP here. The server updates its life bar as it takes damage
+	SetLifeBarPercentage(CurrentHP / MaxHP);
+
+	// HP is replicated state, so clients always end up agreeing with the server on whether we're dead
+	const bool bIsDead = CurrentHP <= 0.0f;
+
+	if (bIsDead != bShowingDeathEffects)
+	{
+		if (bIsDead)
+		{
+			PlayDeathEffects();
+		}
+		else
+		{
+			PlayRespawnEffects();
+		}
+	}
+}
+
+void ACombatEnemy::PlayRespawnEffects()
+{
+	bShowingDeathEffects = false;
+
+	// the ragdoll detached the mesh, so reattach it and restore its transform
+	GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->ReleaseRagdoll(GetMesh());
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetPhysicsBlendWeight(0.0f);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	GetMesh()->SetRelativeTransform(MeshStartingTransform);
+
+	// stop the death animation and any attack in progress
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	// show and fill the life bar
+	SetLifeBarVisible(true);
+	SetLifeBarPercentage(CurrentHP / MaxHP);
+
+	// turn the collision capsule back on
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+}
+
+void ACombatEnemy::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the HUD draws our life bar, so make sure the widget component never creates or renders its widget
+	if (bUseBatchedLifeBar)
+	{
+		LifeBar->SetWidgetClass(nullptr);
+		LifeBar->SetVisibility(false);
+		LifeBar->SetComponentTickEnabled(false);
+	}
+}
+
+void ACombatEnemy::DeactivateForPool()
+{
+	// clear any pending death timer
+	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// stop the StateTree and any AI movement
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		AIController->StopMovement();
+
+		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
+		{
+			BrainComponent->StopLogic(TEXT("Returned to pool"));
+		}
+	}
+
+	// stop being a melee target
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->UnregisterDamageable(this);
+
+	// stop being throttled, so the subsystem doesn't touch our tick while we're pooled. Enemies demoted by a crowd get here without dying first
+	GetWorld()->GetSubsystem<UCombatAILODSubsystem>()->UnregisterEnemy(this);
+
+	// stop the ragdoll
+	GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->ReleaseRagdoll(GetMesh());
+	GetMesh()->SetSimulatePhysics(false);
+
+	// hide the enemy and turn off collision
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	// stop ticking the actor, mesh and movement
+	SetActorTickEnabled(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+}
+
+void ACombatEnemy::ResetForReuse(const FTransform& SpawnTransform)
+{
+	// move to the spawn point, discarding any leftover physics state
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+	// reset the attack state
+	bIsAttacking = false;
+	CurrentSwing.End();
+
+	// reset HP to maximum before the StateTree restarts so it picks it up at the right value.
+	// Clients play the respawn when they see it
+	CurrentHP = MaxHP;
+
+	// restore the mesh and life bar
+	PlayRespawnEffects();
+
+	// turn tick and collision back on
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+
+	// restore movement
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	// become a melee target again
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Enemy, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius(), GetCapsuleComponent()->GetScaledCapsuleHalfHeight_WithoutHemisphere());
+
+	// restart the StateTree
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
+		{
+			BrainComponent->RestartLogic();
+		}
+	}
+
+	// let significance throttle our AI again. Only the server runs the AI
+	if (HasAuthority())
+	{
+		GetWorld()->GetSubsystem<UCombatAILODSubsystem>()->RegisterEnemy(this);
+	}
+}
+
+void ACombatEnemy::SetHP(float NewHP)
+{
+	CurrentHP = FMath::Clamp(NewHP, 0.0f, MaxHP);
+
+	// update the life bar
+	SetLifeBarPercentage(CurrentHP / MaxHP);
+}
+
 float ACombatEnemy::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
 	// only process damage if the character is still alive
@@ -271,11 +551,10 @@ float ACombatEnemy::TakeDamage(float Damage, struct FDamageEvent const& DamageEv
 	else
 	{
 		// update the life bar
-		LifeBarWidget->SetLifePercentage(CurrentHP / MaxHP);
+		SetLifeBarPercentage(CurrentHP / MaxHP);
 
-		// enable partial ragdoll physics, but keep the pelvis vertical
-		GetMesh()->SetPhysicsBlendWeight(0.5f);
-		GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		// blend in partial ragdoll physics, but keep the pelvis vertical. Skipped if the ragdoll budget is full
+		GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StartHitReaction(GetMesh(), PelvisBoneName, HitReactionBlendWeight, HitReactionDuration);
 	}
 
 	// return the received damage amount
@@ -289,28 +568,64 @@ void ACombatEnemy::Landed(const FHitResult& Hit)
 	// is the character still alive?
 	if (CurrentHP >= 0.0f)
 	{
-		// disable ragdoll physics
-		GetMesh()->SetPhysicsBlendWeight(0.0f);
+		// end the hit reaction early
+		GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StopHitReaction(GetMesh());
 	}
 
-	// call the landed Delegate for StateTree
-	OnEnemyLanded.ExecuteIfBound();
+	// count the landing for StateTree
+	++LandedCount;
 }
 
 void ACombatEnemy::BeginPlay()
 {
-	// reset HP to maximum
-	CurrentHP = MaxHP;
+	// reset HP to maximum. Clients keep the replicated value in case we're already dead
+	if (HasAuthority())
+	{
+		CurrentHP = MaxHP;
+	}
 
 	// we top the HP before BeginPlay so StateTree picks it up at the right value
 	Super::BeginPlay();
 
-	// get the life bar widget from the widget comp
-	LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
-	check(LifeBarWidget);
+	// save the relative transform for the mesh so we can reset the ragdoll later
+	MeshStartingTransform = GetMesh()->GetRelativeTransform();
+
+	// take the attack montages from the attack set
+	if (AttackSet)
+	{
+		ComboAttackMontage = AttackSet->GetComboAttackMontage();
+		ChargedAttackMontage = AttackSet->GetChargedAttackMontage();
+	}
+
+	if (bUseBatchedLifeBar)
+	{
+		// add our life bar to the HUD, floating where the widget component is placed
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->RegisterLifeBar(this, LifeBar->GetRelativeLocation(), LifeBarColor);
+	}
+	else
+	{
+		// get the life bar widget from the widget comp
+		LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
+		check(LifeBarWidget);
+
+		// fill the life bar
+		LifeBarWidget->SetLifePercentage(1.0f);
+	}
+
+	// register as a damageable so melee attacks can find us
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Enemy, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius(), GetCapsuleComponent()->GetScaledCapsuleHalfHeight_WithoutHemisphere());
+
+	// throttle our AI, movement and animation based on significance. Only the server runs the AI
+	if (HasAuthority())
+	{
+		GetWorld()->GetSubsystem<UCombatAILODSubsystem>()->RegisterEnemy(this);
+	}
 
-	// fill the life bar
-	LifeBarWidget->SetLifePercentage(1.0f);
+	// apply the HP that replicated before we began play
+	if (!HasAuthority())
+	{
+		OnRep_CurrentHP();
+	}
 }
 
 void ACombatEnemy::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -319,4 +634,40 @@ void ACombatEnemy::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the death timer
 	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// unregister from the damageable registry. The subsystem may already be gone during world teardown
+	if (UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>())
+	{
+		DamageableSubsystem->UnregisterDamageable(this);
+	}
+	// remove our life bar from the HUD. The subsystem may already be gone during world teardown
+	if (UCombatLifeBarSubsystem* LifeBarSubsystem = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBarSubsystem->UnregisterLifeBar(this);
+	}
+
+	// stop counting against the ragdoll budget
+	if (UCombatRagdollSubsystem* RagdollSubsystem = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+	{
+		RagdollSubsystem->ReleaseRagdoll(GetMesh());
+	}
+
+	// stop being throttled. The subsystem may already be gone during world teardown
+	if (UCombatAILODSubsystem* AILODSubsystem = GetWorld()->GetSubsystem<UCombatAILODSubsystem>())
+	{
+		AILODSubsystem->UnregisterEnemy(this);
+	}
+
+	// give back any attack tokens. The subsystem may already be gone during world teardown
+	if (UCombatAttackTokenSubsystem* TokenSubsystem = GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>())
+	{
+		TokenSubsystem->ReleaseAllTokens(this);
+	}
+}
+
+void ACombatEnemy::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatEnemy, CurrentHP);
 }
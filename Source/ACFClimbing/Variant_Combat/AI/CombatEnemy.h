@@ -6,29 +6,30 @@
 #include "GameFramework/Character.h"
 #include "CombatAttacker.h"
 #include "CombatDamageable.h"
+#include "CombatEventReceiver.h"
 #include "Animation/AnimMontage.h"
 #include "Engine/TimerHandle.h"
 #include "CombatEnemy.generated.h"
 
 class UWidgetComponent;
 class UCombatLifeBar;
+class UCombatAttackTrajectories;
+class UCombatAttackSet;
+struct FCombatCompiledAttack;
 class UAnimMontage;
 
-/** Completed attack animation delegate for StateTree */
-DECLARE_DELEGATE(FOnEnemyAttackCompleted);
-
-/** Landed delegate for StateTree */
-DECLARE_DELEGATE(FOnEnemyLanded);
-
 /** Enemy died delegate */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnEnemyDied);
 
+/** Removed from level delegate for pooling spawners */
+DECLARE_DELEGATE_OneParam(FOnEnemyRemovedFromLevel, ACombatEnemy*);
+
 /**
  *  An AI-controlled character with combat capabilities.
  *  Its bundled AI Controller runs logic through StateTree
  */
 UCLASS(abstract)
-class ACombatEnemy : public ACharacter, public ICombatAttacker, public ICombatDamageable
+class ACombatEnemy : public ACharacter, public ICombatAttacker, public ICombatDamageable, public ICombatEventReceiver
 {
 	GENERATED_BODY()
 
@@ -49,8 +50,8 @@ protected:
 
 public:
 
-	/** Current amount of HP the character has */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Damage", meta = (ClampMin = 0, ClampMax = 100))
+	/** Current amount of HP the character has. Replicated so clients can update the life bar */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing=OnRep_CurrentHP, Category="Damage", meta = (ClampMin = 0, ClampMax = 100))
 	float CurrentHP = 0.0f;
 
 protected:
@@ -59,10 +60,26 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Damage")
 	FName PelvisBoneName;
 
+	/** Physics blend weight at the start of a hit reaction */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 1))
+	float HitReactionBlendWeight = 0.5f;
+
+	/** Time a hit reaction takes to blend back to animation */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float HitReactionDuration = 0.6f;
+
 	/** Pointer to the life bar widget */
 	UPROPERTY(EditAnywhere, Category="Damage")
 	UCombatLifeBar* LifeBarWidget;
 
+	/** If true, the life bar is drawn by the HUD together with every other life bar, instead of by the widget component */
+	UPROPERTY(EditAnywhere, Category="Damage")
+	bool bUseBatchedLifeBar = true;
+
+	/** Batched life bar fill color */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (EditCondition = "bUseBatchedLifeBar"))
+	FLinearColor LifeBarColor = FLinearColor::Red;
+
 	/** If true, the character is currently playing an attack animation */
 	bool bIsAttacking = false;
 
@@ -74,6 +91,13 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace", meta = (ClampMin = 0, ClampMax = 500, Units = "cm"))
 	float MeleeTraceRadius = 50.0f;
 
+	/** Optional baked attack trajectories. Damage sources found here don't need an up to date mesh pose */
+	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace")
+	TObjectPtr<UCombatAttackTrajectories> AttackTrajectories;
+
+	/** Swing currently being resolved, so each target is only damaged once per swing */
+	FCombatSwing CurrentSwing;
+
 	/** Amount of damage a melee attack will deal */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Damage", meta = (ClampMin = 0, ClampMax = 100))
 	float MeleeDamage = 1.0f;
@@ -86,6 +110,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Damage", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm/s"))
 	float MeleeLaunchImpulse = 350.0f;
 
+	/** Optional attack set. When set, it replaces the montages and sections below, and sets the damage and trace size of each attack */
+	UPROPERTY(EditAnywhere, Category="Melee Attack")
+	TObjectPtr<UCombatAttackSet> AttackSet;
+
 	/** AnimMontage that will play for combo attacks */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Combo")
 	UAnimMontage* ComboAttackMontage;
@@ -126,6 +154,10 @@ protected:
 	/** Number of charge animation loop currently playing */
 	int32 CurrentChargeLoop = 0;
 
+	/** AnimMontage played on death when the ragdoll budget is full */
+	UPROPERTY(EditAnywhere, Category="Death")
+	UAnimMontage* DeathMontage;
+
 	/** Time to wait before removing this character from the level after it dies */
 	UPROPERTY(EditAnywhere, Category="Death")
 	float DeathRemovalTime = 5.0f;
@@ -133,20 +165,27 @@ protected:
 	/** Enemy death timer */
 	FTimerHandle DeathTimer;
 
+	/** Copy of the mesh's transform so we can reset it after ragdoll animations */
+	FTransform MeshStartingTransform;
+
 	/** Attack montage ended delegate */
 	FOnMontageEnded OnAttackMontageEnded;
 
-public:
-	/** Attack completed internal delegate to notify StateTree tasks */
-	FOnEnemyAttackCompleted OnAttackCompleted;
+	/** Number of attacks finished so far. StateTree tasks compare it against the value they saw on entry to know when their attack is done */
+	uint32 AttackCompletedCount = 0;
+
+	/** Number of landings so far. StateTree tasks compare it against the value they saw on entry to know when the enemy has landed */
+	uint32 LandedCount = 0;
 
-	/** Landed internal delegate to notify StateTree tasks. We use this instead of the built-in Landed delegate so we can bind to a Lambda in StateTree tasks */
-	FOnEnemyLanded OnEnemyLanded;
+public:
 
 	/** Enemy died delegate. Allows external subscribers to respond to enemy death */
 	UPROPERTY(BlueprintAssignable, Category="Events")
 	FOnEnemyDied OnEnemyDied;
 
+	/** If bound, the enemy is deactivated and handed to this delegate instead of being destroyed after death */
+	FOnEnemyRemovedFromLevel OnEnemyRemovedFromLevel;
+
 public:
 
 	/** Performs an AI-initiated combo attack. Number of hits will be decided by this character */
@@ -158,6 +197,18 @@ public:
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Returns true if the enemy is currently playing an attack animation */
+	bool IsAttacking() const { return bIsAttacking; }
+
+	/** Returns the number of attacks finished so far */
+	uint32 GetAttackCompletedCount() const { return AttackCompletedCount; }
+
+	/** Returns the number of landings so far */
+	uint32 GetLandedCount() const { return LandedCount; }
+
+	/** Returns the melee settings passed to the shared melee code */
+	FCombatMeleeSettings GetMeleeSettings() const;
+
 public:
 
 	// ~begin ICombatAttacker interface
@@ -165,6 +216,15 @@ public:
 	/** Performs an attack's collision check */
 	virtual void DoAttackTrace(FName DamageSourceBone) override;
 
+	/** Starts a swing that sweeps the damage source's trajectory */
+	virtual void BeginAttackWindow(FName DamageSourceBone) override;
+
+	/** Sweeps the damage source from its last position to its current one */
+	virtual void TickAttackWindow(FName DamageSourceBone) override;
+
+	/** Performs a final sweep and ends the swing */
+	virtual void EndAttackWindow(FName DamageSourceBone) override;
+
 	/** Performs a combo attack's check to continue the string */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckCombo() override;
@@ -188,11 +248,48 @@ public:
 
 	// ~end ICombatDamageable interface
 
+	// ~begin ICombatEventReceiver interface
+
+	/** Plays the effects of a combat event received from the server */
+	virtual void ReceiveCombatEvent(const FCombatEvent& Event) override;
+
+	// ~end ICombatEventReceiver interface
+
 protected:
 
 	/** Removes this character from the level after it dies */
 	void RemoveFromLevel();
 
+	/** Sets the life bar to the provided 0-1 percentage value */
+	void SetLifeBarPercentage(float Percent);
+
+	/** Shows or hides the life bar */
+	void SetLifeBarVisible(bool bVisible);
+
+	/** Updates the life bar on clients when HP replicates, and plays death or respawn when HP crosses zero */
+	UFUNCTION()
+	void OnRep_CurrentHP();
+
+	/** Ragdolls or plays the death animation and hides the life bar. Cosmetic, shared by the server and clients */
+	void PlayDeathEffects();
+
+	/** Undoes the death effects, restoring the mesh and life bar. Cosmetic, shared by the server and clients */
+	void PlayRespawnEffects();
+
+	/** If true, the death effects are showing */
+	bool bShowingDeathEffects = false;
+
+public:
+
+	/** Hides the enemy and turns off its tick, collision and AI so it can wait in a pool */
+	void DeactivateForPool();
+
+	/** Brings a pooled enemy back to life at the given transform, as if it had just been spawned */
+	void ResetForReuse(const FTransform& SpawnTransform);
+
+	/** Sets the current HP and updates the life bar, e.g. to carry damage over from a crowd agent */
+	void SetHP(float NewHP);
+
 public:
 
 	/** Overrides the default TakeDamage functionality */
@@ -209,9 +306,15 @@ protected:
 
 protected:
 
+	/** Disables the life bar widget if the batched life bar is used */
+	virtual void PostInitializeComponents() override;
+
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
 	/** EndPlay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Registers replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 };
@@ -30,7 +30,29 @@ ACombatEnemySpawner::ACombatEnemySpawner()
 void ACombatEnemySpawner::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// enemies replicate, so only the server spawns them. The spawner doesn't replicate, so clients also have authority over their copy
+	if (GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	// pre-warm the pool so waves don't pay for spawning
+	if (bUseEnemyPool)
+	{
+		// no point creating more enemies than we'll ever need alive
+		const int32 PrewarmCount = FMath::Min(EnemyPoolSize, SpawnCount);
+
+		for (int32 i = 0; i < PrewarmCount; ++i)
+		{
+			if (ACombatEnemy* PooledEnemy = CreateEnemy())
+			{
+				PooledEnemy->DeactivateForPool();
+				EnemyPool.Add(PooledEnemy);
+			}
+		}
+	}
+
 	// should we spawn an enemy right away?
 	if (bShouldSpawnEnemiesImmediately)
 	{
@@ -46,26 +68,67 @@ void ACombatEnemySpawner::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the spawn timer
 	GetWorld()->GetTimerManager().ClearTimer(SpawnTimer);
+
+	// destroy the inactive pooled enemies. Active ones will destroy themselves since we're no longer bound
+	for (ACombatEnemy* PooledEnemy : EnemyPool)
+	{
+		if (IsValid(PooledEnemy))
+		{
+			PooledEnemy->Destroy();
+		}
+	}
+
+	EnemyPool.Empty();
 }
 
 void ACombatEnemySpawner::SpawnEnemy()
+{
+	// reuse a pooled enemy if we have one
+	if (bUseEnemyPool && !EnemyPool.IsEmpty())
+	{
+		ACombatEnemy* PooledEnemy = EnemyPool.Pop(EAllowShrinking::No);
+		PooledEnemy->ResetForReuse(SpawnCapsule->GetComponentTransform());
+		return;
+	}
+
+	// otherwise create a new one
+	CreateEnemy();
+}
+
+ACombatEnemy* ACombatEnemySpawner::CreateEnemy()
 {
 	// ensure the enemy class is valid
-	if (IsValid(EnemyClass))
+	if (!IsValid(EnemyClass))
 	{
-		// spawn the enemy at the reference capsule's transform
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		return nullptr;
+	}
+
+	// spawn the enemy at the reference capsule's transform
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
 
-		ACombatEnemy* SpawnedEnemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, SpawnCapsule->GetComponentTransform(), SpawnParams);
+	ACombatEnemy* SpawnedEnemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, SpawnCapsule->GetComponentTransform(), SpawnParams);
+
+	// was the enemy successfully created?
+	if (SpawnedEnemy)
+	{
+		// subscribe to the death delegate
+		SpawnedEnemy->OnEnemyDied.AddDynamic(this, &ACombatEnemySpawner::OnEnemyDied);
 
-		// was the enemy successfully created?
-		if (SpawnedEnemy)
+		// ask the enemy to come back to us instead of being destroyed
+		if (bUseEnemyPool)
 		{
-			// subscribe to the death delegate
-			SpawnedEnemy->OnEnemyDied.AddDynamic(this, &ACombatEnemySpawner::OnEnemyDied);
+			SpawnedEnemy->OnEnemyRemovedFromLevel.BindUObject(this, &ACombatEnemySpawner::OnEnemyReturnedToPool);
 		}
 	}
+
+	return SpawnedEnemy;
+}
+
+void ACombatEnemySpawner::OnEnemyReturnedToPool(ACombatEnemy* Enemy)
+{
+	// make the enemy available for the next spawn
+	EnemyPool.Add(Enemy);
 }
 
 void ACombatEnemySpawner::OnEnemyDied()
@@ -106,8 +169,8 @@ void ACombatEnemySpawner::ToggleInteraction(AActor* ActivationInstigator)
 
 void ACombatEnemySpawner::ActivateInteraction(AActor* ActivationInstigator)
 {
-	// ensure we're only activated once, and only if we've deferred enemy spawning
-	if (bHasBeenActivated || bShouldSpawnEnemiesImmediately)
+	// ensure we're only activated once, only if we've deferred enemy spawning, and only on the server
+	if (bHasBeenActivated || bShouldSpawnEnemiesImmediately || GetNetMode() == NM_Client)
 	{
 		return;
 	}
@@ -50,6 +50,18 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner", meta = (ClampMin = 0, ClampMax = 10))
 	float RespawnDelay = 5.0f;
 
+	/** If true, enemies are created up front and recycled when they die instead of being spawned and destroyed */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner|Pooling")
+	bool bUseEnemyPool = false;
+
+	/** Number of enemies to create on BeginPlay when pooling. More are created on demand if the pool runs dry */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner|Pooling", meta = (ClampMin = 1, ClampMax = 20, EditCondition = "bUseEnemyPool"))
+	int32 EnemyPoolSize = 2;
+
+	/** Inactive pooled enemies waiting to be reused */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatEnemy>> EnemyPool;
+
 	/** Time to wait after this spawner is depleted before activating the actor list */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Activation", meta = (ClampMin = 0, ClampMax = 10))
 	float ActivationDelay = 1.0f;
@@ -82,6 +94,12 @@ protected:
 	/** Spawn an enemy and subscribe to its death event */
 	void SpawnEnemy();
 
+	/** Creates a new enemy at the spawn point and subscribes to its death event */
+	ACombatEnemy* CreateEnemy();
+
+	/** Called when a pooled enemy has been removed from the level and can be reused */
+	void OnEnemyReturnedToPool(ACombatEnemy* Enemy);
+
 	/** Called when the spawned enemy has died */
 	UFUNCTION()
 	void OnEnemyDied();
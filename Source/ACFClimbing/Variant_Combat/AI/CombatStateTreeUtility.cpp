@@ -8,8 +8,9 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "AIController.h"
 #include "CombatEnemy.h"
-#include "Kismet/GameplayStatics.h"
-#include "StateTreeAsyncExecutionContext.h"
+#include "ACFPlayerInfoSubsystem.h"
+#include "CombatAttackTokenSubsystem.h"
+#include "CombatEQSSubsystem.h"
 
 bool FStateTreeCharacterGroundedCondition::TestCondition(FStateTreeExecutionContext& Context) const
 {
@@ -38,14 +39,8 @@ EStateTreeRunStatus FStateTreeComboAttackTask::EnterState(FStateTreeExecutionCon
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// bind to the on attack completed delegate
-		InstanceData.Character->OnAttackCompleted.BindLambda(
-			[WeakContext = Context.MakeWeakExecutionContext()]()
-			{
-				WeakContext.FinishTask(EStateTreeFinishTaskType::Succeeded);
-			}
-		);
-
+		// remember the attack count so we can tell when this attack completes
+		InstanceData.StartCount = InstanceData.Character->GetAttackCompletedCount();
 
 		// tell the character to do a combo attack
 		InstanceData.Character->DoAIComboAttack();
@@ -54,7 +49,25 @@ EStateTreeRunStatus FStateTreeComboAttackTask::EnterState(FStateTreeExecutionCon
 	return EStateTreeRunStatus::Running;
 }
 
-void FStateTreeComboAttackTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+EStateTreeRunStatus FStateTreeComboAttackTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// has the attack completed since we entered the state?
+	return InstanceData.Character->GetAttackCompletedCount() != InstanceData.StartCount ? EStateTreeRunStatus::Succeeded : EStateTreeRunStatus::Running;
+}
+
+#if WITH_EDITOR
+FText FStateTreeComboAttackTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+{
+	return FText::FromString("<b>Do Combo Attack</b>");
+}
+#endif // WITH_EDITOR
+
+////////////////////////////////////////////////////////////////////
+
+EStateTreeRunStatus FStateTreeChargedAttackTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
@@ -62,21 +75,35 @@ void FStateTreeComboAttackTask::ExitState(FStateTreeExecutionContext& Context, c
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// unbind the on attack completed delegate
-		InstanceData.Character->OnAttackCompleted.Unbind();
+		// remember the attack count so we can tell when this attack completes
+		InstanceData.StartCount = InstanceData.Character->GetAttackCompletedCount();
+
+		// tell the character to do a charged attack
+		InstanceData.Character->DoAIChargedAttack();
 	}
+
+	return EStateTreeRunStatus::Running;
+}
+
+EStateTreeRunStatus FStateTreeChargedAttackTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// has the attack completed since we entered the state?
+	return InstanceData.Character->GetAttackCompletedCount() != InstanceData.StartCount ? EStateTreeRunStatus::Succeeded : EStateTreeRunStatus::Running;
 }
 
 #if WITH_EDITOR
-FText FStateTreeComboAttackTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+FText FStateTreeChargedAttackTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
 {
-	return FText::FromString("<b>Do Combo Attack</b>");
+	return FText::FromString("<b>Do Charged Attack</b>");
 }
 #endif // WITH_EDITOR
 
 ////////////////////////////////////////////////////////////////////
 
-EStateTreeRunStatus FStateTreeChargedAttackTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+EStateTreeRunStatus FStateTreeWaitForLandingTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
@@ -84,22 +111,84 @@ EStateTreeRunStatus FStateTreeChargedAttackTask::EnterState(FStateTreeExecutionC
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// bind to the on attack completed delegate
-		InstanceData.Character->OnAttackCompleted.BindLambda(
-			[WeakContext = Context.MakeWeakExecutionContext()]()
-			{
-				WeakContext.FinishTask(EStateTreeFinishTaskType::Succeeded);
-			}
-		);
+		// remember the landing count so we can tell when the character lands
+		InstanceData.StartCount = InstanceData.Character->GetLandedCount();
+	}
 
-		// tell the character to do a combo attack
-		InstanceData.Character->DoAIChargedAttack();
+	return EStateTreeRunStatus::Running;
+}
+
+EStateTreeRunStatus FStateTreeWaitForLandingTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// has the character landed since we entered the state?
+	return InstanceData.Character->GetLandedCount() != InstanceData.StartCount ? EStateTreeRunStatus::Succeeded : EStateTreeRunStatus::Running;
+}
+
+#if WITH_EDITOR
+FText FStateTreeWaitForLandingTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+{
+	return FText::FromString("<b>Wait for Landing</b>");
+}
+#endif // WITH_EDITOR
+
+////////////////////////////////////////////////////////////////////
+
+bool FStateTreeCanGetAttackTokenCondition::TestCondition(FStateTreeExecutionContext& Context) const
+{
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// would the coordinator let us attack the target?
+	const UCombatAttackTokenSubsystem* TokenSubsystem = InstanceData.Character->GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>();
+	return TokenSubsystem->CanRequestToken(InstanceData.Character, InstanceData.Target, InstanceData.Priority);
+}
+
+#if WITH_EDITOR
+FText FStateTreeCanGetAttackTokenCondition::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+{
+	return FText::FromString("<b>Can Get Attack Token</b>");
+}
+#endif // WITH_EDITOR
+
+////////////////////////////////////////////////////////////////////
+
+EStateTreeRunStatus FStateTreeHoldAttackTokenTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	// have we transitioned from another state?
+	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
+	{
+		// get the instance data
+		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+		// ask the coordinator for a token, and fail the state if the target is already busy
+		UCombatAttackTokenSubsystem* TokenSubsystem = InstanceData.Character->GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>();
+
+		if (!TokenSubsystem->RequestToken(InstanceData.Character, InstanceData.Target, InstanceData.Priority))
+		{
+			InstanceData.TokenTarget = nullptr;
+			return EStateTreeRunStatus::Failed;
+		}
+
+		// remember who the token is against so we give back the right one
+		InstanceData.TokenTarget = InstanceData.Target;
 	}
 
 	return EStateTreeRunStatus::Running;
 }
 
-void FStateTreeChargedAttackTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+EStateTreeRunStatus FStateTreeHoldAttackTokenTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// has a higher priority enemy taken our token?
+	const UCombatAttackTokenSubsystem* TokenSubsystem = InstanceData.Character->GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>();
+	return TokenSubsystem->HasToken(InstanceData.Character, InstanceData.TokenTarget) ? EStateTreeRunStatus::Running : EStateTreeRunStatus::Failed;
+}
+
+void FStateTreeHoldAttackTokenTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
@@ -107,21 +196,25 @@ void FStateTreeChargedAttackTask::ExitState(FStateTreeExecutionContext& Context,
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// unbind the on attack completed delegate
-		InstanceData.Character->OnAttackCompleted.Unbind();
+		// give the token back so other enemies can attack. Release it against the target it was granted for, even if the bound target has changed since
+		if (InstanceData.TokenTarget)
+		{
+			InstanceData.Character->GetWorld()->GetSubsystem<UCombatAttackTokenSubsystem>()->ReleaseToken(InstanceData.Character, InstanceData.TokenTarget);
+			InstanceData.TokenTarget = nullptr;
+		}
 	}
 }
 
 #if WITH_EDITOR
-FText FStateTreeChargedAttackTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+FText FStateTreeHoldAttackTokenTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
 {
-	return FText::FromString("<b>Do Charged Attack</b>");
+	return FText::FromString("<b>Hold Attack Token</b>");
 }
 #endif // WITH_EDITOR
 
 ////////////////////////////////////////////////////////////////////
 
-EStateTreeRunStatus FStateTreeWaitForLandingTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+EStateTreeRunStatus FStateTreeRunCombatEQSTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
@@ -129,19 +222,35 @@ EStateTreeRunStatus FStateTreeWaitForLandingTask::EnterState(FStateTreeExecution
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// bind to the on enemy landed delegate
-		InstanceData.Character->OnEnemyLanded.BindLambda(
-			[WeakContext = Context.MakeWeakExecutionContext()]()
-			{
-				WeakContext.FinishTask(EStateTreeFinishTaskType::Succeeded);
-			}
-		);
+		// queue the query. It will run when the scheduler has budget, or right away from a shared result
+		InstanceData.RequestId = InstanceData.Querier->GetWorld()->GetSubsystem<UCombatEQSSubsystem>()->RequestQuery(InstanceData.Query, InstanceData.Querier, InstanceData.Target, InstanceData.bShareResults);
 	}
 
 	return EStateTreeRunStatus::Running;
 }
 
-void FStateTreeWaitForLandingTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+EStateTreeRunStatus FStateTreeRunCombatEQSTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// has the query run yet?
+	switch (InstanceData.Querier->GetWorld()->GetSubsystem<UCombatEQSSubsystem>()->ConsumeResult(InstanceData.RequestId, InstanceData.ResultLocation))
+	{
+	case ECombatEQSRequestStatus::Pending:
+		return EStateTreeRunStatus::Running;
+
+	case ECombatEQSRequestStatus::Succeeded:
+		InstanceData.RequestId = INDEX_NONE;
+		return EStateTreeRunStatus::Succeeded;
+
+	default:
+		InstanceData.RequestId = INDEX_NONE;
+		return EStateTreeRunStatus::Failed;
+	}
+}
+
+void FStateTreeRunCombatEQSTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
 	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
@@ -149,15 +258,19 @@ void FStateTreeWaitForLandingTask::ExitState(FStateTreeExecutionContext& Context
 		// get the instance data
 		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-		// bind the on enemy landed delegate
-		InstanceData.Character->OnEnemyLanded.Unbind();
+		// drop the request if we're leaving before it ran
+		if (InstanceData.RequestId != INDEX_NONE)
+		{
+			InstanceData.Querier->GetWorld()->GetSubsystem<UCombatEQSSubsystem>()->CancelRequest(InstanceData.RequestId);
+			InstanceData.RequestId = INDEX_NONE;
+		}
 	}
 }
 
 #if WITH_EDITOR
-FText FStateTreeWaitForLandingTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+FText FStateTreeRunCombatEQSTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
 {
-	return FText::FromString("<b>Wait for Landing</b>");
+	return FText::FromString("<b>Run Combat EQS Query</b>");
 }
 #endif // WITH_EDITOR
 
@@ -266,18 +379,24 @@ EStateTreeRunStatus FStateTreeGetPlayerInfoTask::Tick(FStateTreeExecutionContext
 	// get the instance data
 	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-	// get the character possessed by the first local player
-	InstanceData.TargetPlayerCharacter = Cast<ACharacter>(UGameplayStatics::GetPlayerPawn(InstanceData.Character, 0));
+	// find the closest player in this frame's shared player snapshot
+	float DistanceToPlayer = 0.0f;
+	const FACFPlayerSnapshot* Player = InstanceData.Character->GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->FindNearestPlayer(InstanceData.Character->GetActorLocation(), DistanceToPlayer);
+
+	InstanceData.TargetPlayerCharacter = Player ? Player->Character : nullptr;
 
 	// do we have a valid target?
 	if (InstanceData.TargetPlayerCharacter)
 	{
 		// update the last known location
-		InstanceData.TargetPlayerLocation = InstanceData.TargetPlayerCharacter->GetActorLocation();
+		InstanceData.TargetPlayerLocation = Player->Location;
+		InstanceData.DistanceToTarget = DistanceToPlayer;
+	}
+	else
+	{
+		// measure against the last known location
+		InstanceData.DistanceToTarget = FVector::Distance(InstanceData.TargetPlayerLocation, InstanceData.Character->GetActorLocation());
 	}
-
-	// update the distance
-	InstanceData.DistanceToTarget = FVector::Distance(InstanceData.TargetPlayerLocation, InstanceData.Character->GetActorLocation());
 
 	return EStateTreeRunStatus::Running;
 }
@@ -11,6 +11,7 @@
 class ACharacter;
 class AAIController;
 class ACombatEnemy;
+class UEnvQuery;
 
 /**
  *  Instance data struct for the FStateTreeCharacterGroundedCondition condition
@@ -69,6 +70,9 @@ struct FStateTreeAttackInstanceData
 	/** Character that will perform the attack */
 	UPROPERTY(EditAnywhere, Category = Context)
 	TObjectPtr<ACombatEnemy> Character;
+
+	/** Character's attack or landing count when the state was entered. The task finishes once the count moves past it */
+	uint32 StartCount = 0;
 };
 
 /**
@@ -86,8 +90,8 @@ struct FStateTreeComboAttackTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is entered */
 	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
-	/** Runs when the owning state is ended */
-	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+	/** Finishes the task once the character reports it's done */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
 
 #if WITH_EDITOR
 	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
@@ -109,8 +113,8 @@ struct FStateTreeChargedAttackTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is entered */
 	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
-	/** Runs when the owning state is ended */
-	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+	/** Finishes the task once the character reports it's done */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
 
 #if WITH_EDITOR
 	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
@@ -132,6 +136,147 @@ struct FStateTreeWaitForLandingTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is entered */
 	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
+	/** Finishes the task once the character reports it's done */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+#if WITH_EDITOR
+	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
+#endif // WITH_EDITOR
+};
+
+////////////////////////////////////////////////////////////////////
+
+/**
+ *  Instance data struct for the attack token condition and task
+ */
+USTRUCT()
+struct FStateTreeAttackTokenInstanceData
+{
+	GENERATED_BODY()
+
+	/** Character that wants to attack */
+	UPROPERTY(EditAnywhere, Category = Context)
+	TObjectPtr<ACombatEnemy> Character;
+
+	/** Actor the character wants to attack */
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<AActor> Target;
+
+	/** Higher priority requests can take tokens from lower priority enemies that haven't started attacking yet */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	int32 Priority = 0;
+
+	/** Target the hold task was granted a token against. The bound target can change while the state is active */
+	UPROPERTY()
+	TObjectPtr<AActor> TokenTarget;
+};
+
+/**
+ *  StateTree condition to check if the character could get an attack token against its target
+ */
+USTRUCT(DisplayName = "Can Get Attack Token")
+struct FStateTreeCanGetAttackTokenCondition : public FStateTreeConditionCommonBase
+{
+	GENERATED_BODY()
+
+	/** Set the instance data type */
+	using FInstanceDataType = FStateTreeAttackTokenInstanceData;
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/** Default constructor */
+	FStateTreeCanGetAttackTokenCondition() = default;
+
+	/** Tests the StateTree condition */
+	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+#if WITH_EDITOR
+
+	/** Provides the description string */
+	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
+#endif
+
+};
+
+/**
+ *  StateTree task that holds an attack token against the target while its state is active.
+ *  Fails if the token can't be granted or is taken by a higher priority enemy, so the state can fall back to positioning
+ */
+USTRUCT(meta=(DisplayName="Hold Attack Token", Category="Combat"))
+struct FStateTreeHoldAttackTokenTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	/* Ensure we're using the correct instance data struct */
+	using FInstanceDataType = FStateTreeAttackTokenInstanceData;
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/** Runs when the owning state is entered */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/** Fails the task if the token was lost */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	/** Runs when the owning state is ended */
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+#if WITH_EDITOR
+	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
+#endif // WITH_EDITOR
+};
+
+////////////////////////////////////////////////////////////////////
+
+/**
+ *  Instance data struct for the Run Combat EQS Query StateTree task
+ */
+USTRUCT()
+struct FStateTreeCombatEQSInstanceData
+{
+	GENERATED_BODY()
+
+	/** Actor running the query */
+	UPROPERTY(EditAnywhere, Category = Context)
+	TObjectPtr<AActor> Querier;
+
+	/** Actor the query positions around, provided to the query as the Combat Target context. Enemies running the same query around the same target can share results */
+	UPROPERTY(EditAnywhere, Category = Input)
+	TObjectPtr<AActor> Target;
+
+	/** Query to run */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	TObjectPtr<UEnvQuery> Query;
+
+	/** If true, recent results from other enemies with the same query and target are reused */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	bool bShareResults = true;
+
+	/** Location picked by the query */
+	UPROPERTY(EditAnywhere, Category = Output)
+	FVector ResultLocation = FVector::ZeroVector;
+
+	/** Scheduled request, while it's pending */
+	int32 RequestId = INDEX_NONE;
+};
+
+/**
+ *  StateTree task to run a positioning EQS query through the budgeted combat EQS scheduler.
+ *  Succeeds with the picked location once the query has run, or fails if it found nothing
+ */
+USTRUCT(meta=(DisplayName="Run Combat EQS Query", Category="Combat"))
+struct FStateTreeRunCombatEQSTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	/* Ensure we're using the correct instance data struct */
+	using FInstanceDataType = FStateTreeCombatEQSInstanceData;
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/** Runs when the owning state is entered */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/** Waits for the scheduled query to finish */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
 	/** Runs when the owning state is ended */
 	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "EnvQueryContext_CombatTarget.h"
+#include "CombatEQSSubsystem.h"
+#include "EnvironmentQuery/EnvQueryTypes.h"
+#include "EnvironmentQuery/Items/EnvQueryItemType_Actor.h"
+
+void UEnvQueryContext_CombatTarget::ProvideContext(FEnvQueryInstance& QueryInstance, FEnvQueryContextData& ContextData) const
+{
+	// get the target of the request the combat EQS scheduler is running
+	const UCombatEQSSubsystem* EQSSubsystem = QueryInstance.World->GetSubsystem<UCombatEQSSubsystem>();
+	const AActor* Target = EQSSubsystem ? EQSSubsystem->GetRunningTarget() : nullptr;
+
+	// add the actor data to the context. Queries run outside the scheduler get an empty context and fail
+	if (Target)
+	{
+		UEnvQueryItemType_Actor::SetContextHelper(ContextData, Target);
+	}
+	else
+	{
+		UEnvQueryItemType_Actor::SetContextHelper(ContextData, TArray<const AActor*>());
+	}
+}
@@ -0,0 +1,23 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnvironmentQuery/EnvQueryContext.h"
+#include "EnvQueryContext_CombatTarget.generated.h"
+
+/**
+ *  UEnvQueryContext_CombatTarget
+ *  EnvQuery Context that returns the target of the combat EQS request being run.
+ *  Queries that share results per target should position around this context, so the result matches the target it's shared for
+ */
+UCLASS()
+class UEnvQueryContext_CombatTarget : public UEnvQueryContext
+{
+	GENERATED_BODY()
+	
+public:
+
+	/** Provides the context locations or actors for this EnvQuery */
+	virtual void ProvideContext(FEnvQueryInstance& QueryInstance, FEnvQueryContextData& ContextData) const override;
+};
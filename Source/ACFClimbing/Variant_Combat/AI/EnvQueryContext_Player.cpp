@@ -2,17 +2,21 @@
 
 
 #include "EnvQueryContext_Player.h"
-#include "Kismet/GameplayStatics.h"
+#include "ACFPlayerInfoSubsystem.h"
 #include "EnvironmentQuery/EnvQueryTypes.h"
 #include "EnvironmentQuery/Items/EnvQueryItemType_Actor.h"
 #include "GameFramework/Pawn.h"
 
 void UEnvQueryContext_Player::ProvideContext(FEnvQueryInstance& QueryInstance, FEnvQueryContextData& ContextData) const
 {
-	// get the player pawn for the first local player
-	AActor* PlayerPawn = UGameplayStatics::GetPlayerPawn(QueryInstance.Owner.Get(), 0);
-	check(PlayerPawn);
+	// get every player's pawn from this frame's shared player snapshot
+	TArray<const AActor*> PlayerPawns;
 
-	// add the actor data to the context
-	UEnvQueryItemType_Actor::SetContextHelper(ContextData, PlayerPawn);
+	for (const FACFPlayerSnapshot& Player : QueryInstance.World->GetSubsystem<UACFPlayerInfoSubsystem>()->GetPlayers())
+	{
+		PlayerPawns.Add(Player.Pawn);
+	}
+
+	// add the actor data to the context. An empty context makes the query fail instead of asserting
+	UEnvQueryItemType_Actor::SetContextHelper(ContextData, PlayerPawns);
 }
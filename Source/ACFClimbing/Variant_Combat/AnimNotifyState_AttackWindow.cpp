@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "AnimNotifyState_AttackWindow.h"
+#include "CombatAttacker.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void UAnimNotifyState_AttackWindow::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration, const FAnimNotifyEventReference& EventReference)
+{
+	// cast the owner to the attacker interface
+	if (ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(MeshComp->GetOwner()))
+	{
+		AttackerInterface->BeginAttackWindow(AttackBoneName);
+	}
+}
+
+void UAnimNotifyState_AttackWindow::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float FrameDeltaTime, const FAnimNotifyEventReference& EventReference)
+{
+	// cast the owner to the attacker interface
+	if (ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(MeshComp->GetOwner()))
+	{
+		AttackerInterface->TickAttackWindow(AttackBoneName);
+	}
+}
+
+void UAnimNotifyState_AttackWindow::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	// cast the owner to the attacker interface
+	if (ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(MeshComp->GetOwner()))
+	{
+		AttackerInterface->EndAttackWindow(AttackBoneName);
+	}
+}
+
+FString UAnimNotifyState_AttackWindow::GetNotifyName_Implementation() const
+{
+	return FString("Attack Window");
+}
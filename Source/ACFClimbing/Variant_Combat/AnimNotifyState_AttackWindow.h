@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "AnimNotifyState_AttackWindow.generated.h"
+
+/**
+ *  AnimNotifyState to open an attack window on the actor.
+ *  While the window is open, the attack bone's trajectory is swept every frame and each target is damaged once.
+ */
+UCLASS()
+class UAnimNotifyState_AttackWindow : public UAnimNotifyState
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Source bone for the attack sweeps */
+	UPROPERTY(EditAnywhere, Category="Attack")
+	FName AttackBoneName;
+
+public:
+
+	/** Open the attack window */
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration, const FAnimNotifyEventReference& EventReference) override;
+
+	/** Sweep the attack bone since the last frame */
+	virtual void NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float FrameDeltaTime, const FAnimNotifyEventReference& EventReference) override;
+
+	/** Close the attack window */
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
+
+	/** Get the notify name */
+	virtual FString GetNotifyName_Implementation() const override;
+};
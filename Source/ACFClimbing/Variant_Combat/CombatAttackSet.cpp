@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAttackSet.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimInstance.h"
+#include "AnimNotifyState_AttackWindow.h"
+#include "AnimNotify_DoAttackTrace.h"
+#include "AnimNotify_CheckCombo.h"
+#include "AnimNotify_CheckChargedAttack.h"
+#include "Misc/DataValidation.h"
+#include "UObject/ObjectSaveContext.h"
+
+#define LOCTEXT_NAMESPACE "CombatAttackSet"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCombatAttackSet, Log, All);
+
+namespace CombatAttackSet
+{
+	/** Returns true if the montage has a notify of the given class triggering inside the time range */
+	bool HasNotifyInRange(const UAnimMontage* Montage, const UClass* NotifyClass, float StartTime, float EndTime)
+	{
+		for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+		{
+			const UObject* Notify = NotifyEvent.NotifyStateClass ? static_cast<const UObject*>(NotifyEvent.NotifyStateClass.Get()) : static_cast<const UObject*>(NotifyEvent.Notify.Get());
+			const float TriggerTime = NotifyEvent.GetTriggerTime();
+
+			if (Notify && Notify->IsA(NotifyClass) && TriggerTime >= StartTime && TriggerTime < EndTime)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+const FCombatCompiledAttack* UCombatAttackSet::FindAttack(const UAnimMontage* Montage, int32 SectionIndex) const
+{
+	if (!Montage)
+	{
+		return nullptr;
+	}
+
+	if (Montage == ComboAttackMontage)
+	{
+		// the combo montage has a lookup table since it plays several attacks
+		return ComboAttacksBySection.IsValidIndex(SectionIndex) && ComboAttacksBySection[SectionIndex] != INDEX_NONE
+			? &CompiledComboAttacks[ComboAttacksBySection[SectionIndex]]
+			: nullptr;
+	}
+
+	if (Montage == ChargedAttackMontage && SectionIndex != INDEX_NONE && SectionIndex == CompiledChargeAttack.SectionIndex)
+	{
+		return &CompiledChargeAttack;
+	}
+
+	return nullptr;
+}
+
+void UCombatAttackSet::JumpToSection(UAnimInstance* AnimInstance, UAnimMontage* Montage, int32 SectionIndex)
+{
+	if (AnimInstance && Montage && Montage->IsValidSectionIndex(SectionIndex))
+	{
+		AnimInstance->Montage_SetPosition(Montage, Montage->GetAnimCompositeSection(SectionIndex).GetTime());
+	}
+}
+
+void UCombatAttackSet::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileAttacks();
+}
+
+#if WITH_EDITOR
+
+void UCombatAttackSet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	CompileAttacks();
+}
+
+EDataValidationResult UCombatAttackSet::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	TArray<FText> Errors;
+	GetConfigurationErrors(Errors);
+
+	for (const FText& Error : Errors)
+	{
+		Context.AddError(Error);
+	}
+
+	return Errors.IsEmpty() ? Result : EDataValidationResult::Invalid;
+}
+
+void UCombatAttackSet::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// errors logged while cooking fail the cook, so broken attacks never ship
+	if (SaveContext.IsCooking())
+	{
+		TArray<FText> Errors;
+		GetConfigurationErrors(Errors);
+
+		for (const FText& Error : Errors)
+		{
+			UE_LOG(LogCombatAttackSet, Error, TEXT("%s: %s"), *GetPathName(), *Error.ToString());
+		}
+	}
+}
+
+#endif // WITH_EDITOR
+
+void UCombatAttackSet::CompileAttacks()
+{
+	CompiledComboAttacks.Reset();
+	ComboAttacksBySection.Reset();
+	CompiledChargeAttack = FCombatCompiledAttack();
+	ChargeLoopSectionIndex = INDEX_NONE;
+
+	// make sure the montages' sections and notifies are loaded before reading them
+	if (ComboAttackMontage)
+	{
+		ComboAttackMontage->ConditionalPostLoad();
+		ComboAttacksBySection.Init(INDEX_NONE, ComboAttackMontage->CompositeSections.Num());
+
+		// the combo stops at the first stage that doesn't compile, so the stage indices always match the combo count
+		for (const FCombatAttackDefinition& Attack : ComboAttacks)
+		{
+			FCombatCompiledAttack CompiledAttack;
+
+			if (!CompileAttack(ComboAttackMontage, Attack, CompiledAttack))
+			{
+				break;
+			}
+
+			ComboAttacksBySection[CompiledAttack.SectionIndex] = CompiledComboAttacks.Add(CompiledAttack);
+		}
+	}
+
+	if (ChargedAttackMontage)
+	{
+		ChargedAttackMontage->ConditionalPostLoad();
+		ChargeLoopSectionIndex = ChargedAttackMontage->GetSectionIndex(ChargeLoopSection);
+		CompileAttack(ChargedAttackMontage, ChargeAttack, CompiledChargeAttack);
+	}
+}
+
+bool UCombatAttackSet::CompileAttack(const UAnimMontage* Montage, const FCombatAttackDefinition& Attack, FCombatCompiledAttack& OutAttack)
+{
+	const int32 SectionIndex = Montage->GetSectionIndex(Attack.SectionName);
+
+	if (SectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutAttack.SectionIndex = SectionIndex;
+	OutAttack.StartTime = Montage->GetAnimCompositeSection(SectionIndex).GetTime();
+	OutAttack.Length = Montage->GetSectionLength(SectionIndex);
+	OutAttack.Damage = Attack.Damage;
+	OutAttack.TraceDistance = Attack.TraceDistance;
+	OutAttack.TraceRadius = Attack.TraceRadius;
+
+	// find the time range the section deals damage in
+	const float EndTime = OutAttack.StartTime + OutAttack.Length;
+	OutAttack.WindowStartTime = EndTime;
+	OutAttack.WindowEndTime = OutAttack.StartTime;
+
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		const float TriggerTime = NotifyEvent.GetTriggerTime();
+
+		if (TriggerTime < OutAttack.StartTime || TriggerTime >= EndTime)
+		{
+			continue;
+		}
+
+		const bool bIsWindow = NotifyEvent.NotifyStateClass && NotifyEvent.NotifyStateClass->IsA<UAnimNotifyState_AttackWindow>();
+		const bool bIsTrace = NotifyEvent.Notify && NotifyEvent.Notify->IsA<UAnimNotify_DoAttackTrace>();
+
+		if (bIsWindow || bIsTrace)
+		{
+			OutAttack.WindowStartTime = FMath::Min(OutAttack.WindowStartTime, TriggerTime);
+			OutAttack.WindowEndTime = FMath::Max(OutAttack.WindowEndTime, bIsWindow ? NotifyEvent.GetEndTriggerTime() : TriggerTime);
+		}
+	}
+
+	// sections without attack notifies have an empty window
+	OutAttack.WindowStartTime = FMath::Min(OutAttack.WindowStartTime, OutAttack.WindowEndTime);
+
+	return true;
+}
+
+void UCombatAttackSet::GetConfigurationErrors(TArray<FText>& OutErrors) const
+{
+	// validate the combo stages
+	if (!ComboAttackMontage)
+	{
+		OutErrors.Add(LOCTEXT("MissingComboMontage", "No combo attack montage is set."));
+	}
+	else
+	{
+		if (ComboAttacks.IsEmpty())
+		{
+			OutErrors.Add(LOCTEXT("NoComboAttacks", "The combo has no attacks."));
+		}
+
+		for (int32 i = 0; i < ComboAttacks.Num(); ++i)
+		{
+			FCombatCompiledAttack CompiledAttack;
+
+			if (!CompileAttack(ComboAttackMontage, ComboAttacks[i], CompiledAttack))
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("MissingComboSection", "Combo attack {0} plays section '{1}', which doesn't exist on {2}."),
+					i, FText::FromName(ComboAttacks[i].SectionName), FText::FromString(ComboAttackMontage->GetName())));
+				continue;
+			}
+
+			const float EndTime = CompiledAttack.StartTime + CompiledAttack.Length;
+
+			if (!CombatAttackSet::HasNotifyInRange(ComboAttackMontage, UAnimNotifyState_AttackWindow::StaticClass(), CompiledAttack.StartTime, EndTime)
+				&& !CombatAttackSet::HasNotifyInRange(ComboAttackMontage, UAnimNotify_DoAttackTrace::StaticClass(), CompiledAttack.StartTime, EndTime))
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("NoComboWindow", "Combo attack {0} (section '{1}') has no attack window or attack trace notify, so it can't deal damage."),
+					i, FText::FromName(ComboAttacks[i].SectionName)));
+			}
+
+			// every stage but the last needs to check for the next combo input
+			if (i < ComboAttacks.Num() - 1 && !CombatAttackSet::HasNotifyInRange(ComboAttackMontage, UAnimNotify_CheckCombo::StaticClass(), CompiledAttack.StartTime, EndTime))
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("NoComboCheck", "Combo attack {0} (section '{1}') has no check combo notify, so the combo can never continue past it."),
+					i, FText::FromName(ComboAttacks[i].SectionName)));
+			}
+		}
+	}
+
+	// validate the charged attack
+	if (!ChargedAttackMontage)
+	{
+		OutErrors.Add(LOCTEXT("MissingChargedMontage", "No charged attack montage is set."));
+		return;
+	}
+
+	const int32 LoopSectionIndex = ChargedAttackMontage->GetSectionIndex(ChargeLoopSection);
+
+	if (LoopSectionIndex == INDEX_NONE)
+	{
+		OutErrors.Add(FText::Format(LOCTEXT("MissingLoopSection", "The charge loop section '{0}' doesn't exist on {1}."),
+			FText::FromName(ChargeLoopSection), FText::FromString(ChargedAttackMontage->GetName())));
+	}
+	else
+	{
+		const float LoopStartTime = ChargedAttackMontage->GetAnimCompositeSection(LoopSectionIndex).GetTime();
+		const float LoopEndTime = LoopStartTime + ChargedAttackMontage->GetSectionLength(LoopSectionIndex);
+
+		if (!CombatAttackSet::HasNotifyInRange(ChargedAttackMontage, UAnimNotify_CheckChargedAttack::StaticClass(), LoopStartTime, LoopEndTime))
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("NoChargeCheck", "The charge loop section '{0}' has no check charged attack notify, so the charge can never be released."),
+				FText::FromName(ChargeLoopSection)));
+		}
+	}
+
+	FCombatCompiledAttack CompiledChargeAttackCheck;
+
+	if (!CompileAttack(ChargedAttackMontage, ChargeAttack, CompiledChargeAttackCheck))
+	{
+		OutErrors.Add(FText::Format(LOCTEXT("MissingChargeSection", "The charge attack section '{0}' doesn't exist on {1}."),
+			FText::FromName(ChargeAttack.SectionName), FText::FromString(ChargedAttackMontage->GetName())));
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
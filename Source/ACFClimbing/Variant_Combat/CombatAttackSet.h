@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CombatAttackSet.generated.h"
+
+class UAnimMontage;
+class UAnimInstance;
+
+/**
+ *  A single attack in an attack set, played from a montage section
+ */
+USTRUCT()
+struct FCombatAttackDefinition
+{
+	GENERATED_BODY()
+
+	/** Montage section that plays the attack */
+	UPROPERTY(EditAnywhere, Category="Attack")
+	FName SectionName;
+
+	/** Amount of damage the attack will deal */
+	UPROPERTY(EditAnywhere, Category="Attack", meta = (ClampMin = 0, ClampMax = 100))
+	float Damage = 1.0f;
+
+	/** Distance ahead of the character that the attack's sphere traces will extend */
+	UPROPERTY(EditAnywhere, Category="Attack", meta = (ClampMin = 0, ClampMax = 500, Units = "cm"))
+	float TraceDistance = 75.0f;
+
+	/** Radius of the attack's sphere traces */
+	UPROPERTY(EditAnywhere, Category="Attack", meta = (ClampMin = 0, ClampMax = 500, Units = "cm"))
+	float TraceRadius = 75.0f;
+};
+
+/**
+ *  An attack resolved against its montage, so it can be played and looked up by index
+ */
+struct FCombatCompiledAttack
+{
+	/** Montage section index */
+	int32 SectionIndex = INDEX_NONE;
+
+	/** Montage time the section starts at */
+	float StartTime = 0.0f;
+
+	/** Section length */
+	float Length = 0.0f;
+
+	/** Montage time the first attack window or trace in the section starts at */
+	float WindowStartTime = 0.0f;
+
+	/** Montage time the last attack window or trace in the section ends at */
+	float WindowEndTime = 0.0f;
+
+	/** Amount of damage the attack will deal */
+	float Damage = 0.0f;
+
+	/** Distance ahead of the character that the attack's sphere traces will extend */
+	float TraceDistance = 0.0f;
+
+	/** Radius of the attack's sphere traces */
+	float TraceRadius = 0.0f;
+};
+
+/**
+ *  Combo and charged attack definitions for a combat character.
+ *  Section names are resolved against the montages once on load, so attacks are played and looked up by section index,
+ *  and misconfigured sections or missing attack notifies are reported by data validation and fail the cook
+ */
+UCLASS(BlueprintType)
+class UCombatAttackSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** AnimMontage that will play for combo attacks */
+	UPROPERTY(EditAnywhere, Category="Combo")
+	TObjectPtr<UAnimMontage> ComboAttackMontage;
+
+	/** Each stage of the combo attack, in order */
+	UPROPERTY(EditAnywhere, Category="Combo")
+	TArray<FCombatAttackDefinition> ComboAttacks;
+
+	/** AnimMontage that will play for charged attacks */
+	UPROPERTY(EditAnywhere, Category="Charged")
+	TObjectPtr<UAnimMontage> ChargedAttackMontage;
+
+	/** Name of the AnimMontage section that corresponds to the charge loop */
+	UPROPERTY(EditAnywhere, Category="Charged")
+	FName ChargeLoopSection;
+
+	/** Attack released at the end of the charge */
+	UPROPERTY(EditAnywhere, Category="Charged")
+	FCombatAttackDefinition ChargeAttack;
+
+	/** Compiled combo stages */
+	TArray<FCombatCompiledAttack> CompiledComboAttacks;
+
+	/** Compiled charged attack */
+	FCombatCompiledAttack CompiledChargeAttack;
+
+	/** Section index of the charge loop */
+	int32 ChargeLoopSectionIndex = INDEX_NONE;
+
+	/** Compiled combo stage for each combo montage section, or INDEX_NONE */
+	TArray<int32> ComboAttacksBySection;
+
+public:
+
+	/** Returns the combo attack montage */
+	UAnimMontage* GetComboAttackMontage() const { return ComboAttackMontage; }
+
+	/** Returns the charged attack montage */
+	UAnimMontage* GetChargedAttackMontage() const { return ChargedAttackMontage; }
+
+	/** Returns the number of combo stages that compiled */
+	int32 GetNumComboAttacks() const { return CompiledComboAttacks.Num(); }
+
+	/** Returns a compiled combo stage */
+	const FCombatCompiledAttack& GetComboAttack(int32 ComboIndex) const { return CompiledComboAttacks[ComboIndex]; }
+
+	/** Returns the compiled charged attack */
+	const FCombatCompiledAttack& GetChargeAttack() const { return CompiledChargeAttack; }
+
+	/** Returns the charge loop section index */
+	int32 GetChargeLoopSectionIndex() const { return ChargeLoopSectionIndex; }
+
+	/** Returns the attack played by a montage section, or nullptr if the section isn't an attack */
+	const FCombatCompiledAttack* FindAttack(const UAnimMontage* Montage, int32 SectionIndex) const;
+
+	/** Jumps the playing montage to the start of a section by index, skipping the section name lookup */
+	static void JumpToSection(UAnimInstance* AnimInstance, UAnimMontage* Montage, int32 SectionIndex);
+
+	/** Compiles the attack tables */
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+
+	/** Recompiles the attack tables after an edit */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	/** Reports misconfigured attacks */
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+
+	/** Fails the cook if the attacks are misconfigured */
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+#endif // WITH_EDITOR
+
+protected:
+
+	/** Resolves every attack against its montage */
+	void CompileAttacks();
+
+	/** Resolves a single attack against its montage. Returns false if the section can't be found */
+	static bool CompileAttack(const UAnimMontage* Montage, const FCombatAttackDefinition& Attack, FCombatCompiledAttack& OutAttack);
+
+	/** Adds a description of every configuration problem to the list */
+	void GetConfigurationErrors(TArray<FText>& OutErrors) const;
+};
@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAttackTrajectories.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "UObject/ObjectSaveContext.h"
+
+bool UCombatAttackTrajectories::SampleTrajectory(const UAnimMontage* Montage, FName DamageSourceBone, float Position, const FTransform& ComponentTransform, FVector& OutLocation) const
+{
+	// find the trajectory for this montage and bone. There are only a handful, so a linear search is fine
+	const FCombatBakedTrajectory* Trajectory = Trajectories.FindByPredicate([Montage, DamageSourceBone](const FCombatBakedTrajectory& Candidate)
+	{
+		return Candidate.Montage == Montage && Candidate.DamageSourceBone == DamageSourceBone;
+	});
+
+	if (!Trajectory || Trajectory->Samples.IsEmpty())
+	{
+		return false;
+	}
+
+	// find the two samples around the montage position
+	const float SamplePosition = FMath::Max(Position, 0.0f) * Trajectory->SampleRate;
+	const int32 LastSample = Trajectory->Samples.Num() - 1;
+	const int32 FromSample = FMath::Min(FMath::FloorToInt32(SamplePosition), LastSample);
+	const int32 ToSample = FMath::Min(FromSample + 1, LastSample);
+
+	// blend between them and move the result into world space
+	const FVector3f ComponentLocation = FMath::Lerp(Trajectory->Samples[FromSample], Trajectory->Samples[ToSample], FMath::Clamp(SamplePosition - FromSample, 0.0f, 1.0f));
+	OutLocation = ComponentTransform.TransformPosition(FVector(ComponentLocation));
+
+	return true;
+}
+
+void UCombatAttackTrajectories::BakeTrajectories()
+{
+#if WITH_EDITOR
+
+	// record the change for undo and mark the asset dirty
+	Modify();
+
+	RebuildTrajectories();
+
+#endif // WITH_EDITOR
+}
+
+#if WITH_EDITOR
+
+void UCombatAttackTrajectories::PreSave(FObjectPreSaveContext SaveContext)
+{
+	// rebake so the saved or cooked data always matches the source montages
+	RebuildTrajectories();
+
+	Super::PreSave(SaveContext);
+}
+
+void UCombatAttackTrajectories::RebuildTrajectories()
+{
+	Trajectories.Reset();
+
+	// bake every montage and bone pair
+	for (const UAnimMontage* Montage : Montages)
+	{
+		if (!Montage)
+		{
+			continue;
+		}
+
+		for (const FName& DamageSourceBone : DamageSourceBones)
+		{
+			FCombatBakedTrajectory Trajectory;
+
+			if (BakeTrajectory(Montage, DamageSourceBone, Trajectory))
+			{
+				Trajectories.Add(MoveTemp(Trajectory));
+			}
+		}
+	}
+}
+
+bool UCombatAttackTrajectories::BakeTrajectory(const UAnimMontage* Montage, FName DamageSourceBone, FCombatBakedTrajectory& OutTrajectory) const
+{
+	const USkeleton* Skeleton = Montage->GetSkeleton();
+
+	if (!Skeleton)
+	{
+		return false;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+
+	// resolve sockets to their parent bone and local offset
+	FName BoneName = DamageSourceBone;
+	FTransform SourceOffset = FTransform::Identity;
+
+	if (const USkeletalMeshSocket* Socket = Skeleton->FindSocket(DamageSourceBone))
+	{
+		BoneName = Socket->BoneName;
+		SourceOffset = Socket->GetSocketLocalTransform();
+	}
+
+	const int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+
+	if (BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutTrajectory.Montage = Montage;
+	OutTrajectory.DamageSourceBone = DamageSourceBone;
+	OutTrajectory.SampleRate = SampleRate;
+
+	// sample the whole montage so every section is covered
+	const float PlayLength = Montage->GetPlayLength();
+	const int32 NumSamples = FMath::FloorToInt32(PlayLength * SampleRate) + 1;
+	OutTrajectory.Samples.Reset(NumSamples);
+
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		const float Time = FMath::Min(SampleIndex / SampleRate, PlayLength);
+
+		// find the sequence playing on the montage's first slot at this time
+		const FAnimSegment* Segment = Montage->SlotAnimTracks.IsEmpty() ? nullptr : Montage->SlotAnimTracks[0].AnimTrack.GetSegmentAtTime(Time);
+		const UAnimSequence* Sequence = Segment ? Cast<UAnimSequence>(Segment->GetAnimReference()) : nullptr;
+		const double SequenceTime = Segment ? Segment->ConvertTrackPosToAnimPos(Time) : 0.0;
+
+		// walk up the hierarchy to build the component space transform
+		FTransform ComponentSpace = SourceOffset;
+
+		for (int32 Index = BoneIndex; Index > 0; Index = RefSkeleton.GetParentIndex(Index))
+		{
+			FTransform LocalTransform = RefSkeleton.GetRefBonePose()[Index];
+
+			if (Sequence)
+			{
+				Sequence->GetBoneTransform(LocalTransform, FSkeletonPoseBoneIndex(Index), SequenceTime, false);
+			}
+
+			ComponentSpace = ComponentSpace * LocalTransform;
+		}
+
+		// use the reference pose for the root, so root motion doesn't end up in the trajectory
+		ComponentSpace = ComponentSpace * RefSkeleton.GetRefBonePose()[0];
+
+		OutTrajectory.Samples.Add(FVector3f(ComponentSpace.GetLocation()));
+	}
+
+	return true;
+}
+
+#endif // WITH_EDITOR
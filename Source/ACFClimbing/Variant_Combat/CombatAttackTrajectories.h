@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "CombatAttackTrajectories.generated.h"
+
+class UAnimMontage;
+
+/**
+ *  Positions of a damage source bone sampled over an attack montage at a fixed rate.
+ *  Positions are in mesh component space, with root motion removed
+ */
+USTRUCT()
+struct FCombatBakedTrajectory
+{
+	GENERATED_BODY()
+
+	/** Montage the trajectory was sampled from */
+	UPROPERTY(VisibleAnywhere, Category="Trajectory")
+	TObjectPtr<const UAnimMontage> Montage;
+
+	/** Bone or socket the trajectory follows */
+	UPROPERTY(VisibleAnywhere, Category="Trajectory")
+	FName DamageSourceBone;
+
+	/** Samples per second of montage time */
+	UPROPERTY(VisibleAnywhere, Category="Trajectory")
+	float SampleRate = 30.0f;
+
+	/** Sampled component space positions, starting at montage position zero */
+	UPROPERTY(VisibleAnywhere, Category="Trajectory")
+	TArray<FVector3f> Samples;
+};
+
+/**
+ *  Attack trajectories baked from attack montages in the editor.
+ *  Lets melee attacks find their damage source from the montage position alone,
+ *  so attacks resolve correctly even when the mesh pose isn't evaluated every frame
+ */
+UCLASS(BlueprintType)
+class UCombatAttackTrajectories : public UDataAsset
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Montages to bake */
+	UPROPERTY(EditAnywhere, Category="Bake")
+	TArray<TObjectPtr<const UAnimMontage>> Montages;
+
+	/** Bones or sockets to bake for each montage */
+	UPROPERTY(EditAnywhere, Category="Bake")
+	TArray<FName> DamageSourceBones;
+
+	/** Number of samples per second of montage time */
+	UPROPERTY(EditAnywhere, Category="Bake", meta = (ClampMin = 1, ClampMax = 120, Units = "Hz"))
+	float SampleRate = 30.0f;
+
+	/** Baked trajectories. Rebaked every time the asset is saved */
+	UPROPERTY(VisibleAnywhere, Category="Baked")
+	TArray<FCombatBakedTrajectory> Trajectories;
+
+public:
+
+	/**
+	 *  Finds the damage source location for a montage position.
+	 *  Returns false if the montage and bone pair wasn't baked
+	 */
+	bool SampleTrajectory(const UAnimMontage* Montage, FName DamageSourceBone, float Position, const FTransform& ComponentTransform, FVector& OutLocation) const;
+
+	/** Samples every montage and bone pair into the baked trajectories */
+	UFUNCTION(CallInEditor, Category="Bake")
+	void BakeTrajectories();
+
+#if WITH_EDITOR
+
+	/** Rebakes before saving or cooking so the trajectories never go stale */
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+#endif // WITH_EDITOR
+
+protected:
+
+#if WITH_EDITOR
+
+	/** Replaces the baked trajectories with fresh samples of every montage and bone pair */
+	void RebuildTrajectories();
+
+	/** Samples a single montage and bone pair. Returns false if the bone can't be found on the montage's skeleton */
+	bool BakeTrajectory(const UAnimMontage* Montage, FName DamageSourceBone, FCombatBakedTrajectory& OutTrajectory) const;
+
+#endif // WITH_EDITOR
+};
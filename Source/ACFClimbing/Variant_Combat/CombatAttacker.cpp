@@ -2,3 +2,231 @@
 
 
 #include "CombatAttacker.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Engine/World.h"
+#include "CombatAttackSet.h"
+#include "CombatAttackTrajectories.h"
+#include "CombatDamageQueueSubsystem.h"
+#include "CombatEventReceiver.h"
+
+/** Id handed to the next swing that starts */
+static uint32 NextCombatSwingId = 1;
+
+void FCombatSwing::Begin(FName InSourceBone, const FVector& SourceLocation)
+{
+	// assign a new id, skipping zero on wraparound since it means no active swing
+	SwingId = NextCombatSwingId++;
+
+	if (NextCombatSwingId == 0)
+	{
+		NextCombatSwingId = 1;
+	}
+
+	SourceBone = InSourceBone;
+	LastSourceLocation = SourceLocation;
+
+	// start with an empty hit set
+	HitActors.Reset();
+}
+
+void FCombatSwing::End()
+{
+	SwingId = 0;
+	HitActors.Reset();
+}
+
+bool FCombatSwing::AddHitActor(const AActor* Actor, int32 Item)
+{
+	const TPair<TObjectKey<AActor>, int32> HitKey(TObjectKey<AActor>(Actor), Item);
+
+	// the hit set is small, a linear search beats hashing
+	if (HitActors.Contains(HitKey))
+	{
+		return false;
+	}
+
+	HitActors.Add(HitKey);
+	return true;
+}
+
+FVector FCombatMelee::GetDamageSourceLocation(const ACharacter* Attacker, const UCombatAttackTrajectories* AttackTrajectories, FName DamageSourceBone)
+{
+	const USkeletalMeshComponent* Mesh = Attacker->GetMesh();
+
+	// prefer the baked trajectory for the playing montage, so we don't depend on the pose being evaluated this frame
+	if (AttackTrajectories)
+	{
+		if (const UAnimInstance* AnimInstance = Mesh->GetAnimInstance())
+		{
+			if (const UAnimMontage* Montage = AnimInstance->GetCurrentActiveMontage())
+			{
+				FVector SourceLocation;
+
+				if (AttackTrajectories->SampleTrajectory(Montage, DamageSourceBone, AnimInstance->Montage_GetPosition(Montage), Mesh->GetComponentTransform(), SourceLocation))
+				{
+					return SourceLocation;
+				}
+			}
+		}
+	}
+
+	// fall back to the current mesh pose
+	return Mesh->GetSocketLocation(DamageSourceBone);
+}
+
+const FCombatCompiledAttack* FCombatMelee::GetCurrentAttack(const ACharacter* Attacker, const UCombatAttackSet* AttackSet)
+{
+	if (!AttackSet)
+	{
+		return nullptr;
+	}
+
+	// look the attack up by the section the montage is in
+	if (const UAnimInstance* AnimInstance = Attacker->GetMesh()->GetAnimInstance())
+	{
+		if (const UAnimMontage* Montage = AnimInstance->GetCurrentActiveMontage())
+		{
+			return AttackSet->FindAttack(Montage, Montage->GetSectionIndexFromPosition(AnimInstance->Montage_GetPosition(Montage)));
+		}
+	}
+
+	return nullptr;
+}
+
+void FCombatMelee::DoAttackTrace(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone)
+{
+	// start at the provided socket location, sweep forward
+	const FCombatCompiledAttack* CurrentAttack = GetCurrentAttack(Attacker, Settings.AttackSet);
+	const FVector TraceStart = GetDamageSourceLocation(Attacker, Settings.AttackTrajectories, DamageSourceBone);
+	const FVector TraceEnd = TraceStart + (Attacker->GetActorForwardVector() * (CurrentAttack ? CurrentAttack->TraceDistance : Settings.TraceDistance));
+
+	// a one-shot trace outside of an attack window is its own swing
+	const bool bOneShotSwing = !Swing.IsActive();
+
+	if (bOneShotSwing)
+	{
+		Swing.Begin(DamageSourceBone, TraceStart);
+	}
+
+	SweepMeleeAttack(Attacker, Swing, Settings, TraceStart, TraceEnd);
+
+	if (bOneShotSwing)
+	{
+		Swing.End();
+	}
+}
+
+void FCombatMelee::BeginAttackWindow(const ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone)
+{
+	// start a new swing from the bone's current position
+	Swing.Begin(DamageSourceBone, GetDamageSourceLocation(Attacker, Settings.AttackTrajectories, DamageSourceBone));
+}
+
+void FCombatMelee::TickAttackWindow(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone)
+{
+	// ignore windows we didn't open
+	if (!Swing.IsActiveFor(DamageSourceBone))
+	{
+		return;
+	}
+
+	// sweep the bone's actual trajectory since the last frame
+	const FVector SourceLocation = GetDamageSourceLocation(Attacker, Settings.AttackTrajectories, DamageSourceBone);
+	SweepMeleeAttack(Attacker, Swing, Settings, Swing.LastSourceLocation, SourceLocation);
+
+	Swing.LastSourceLocation = SourceLocation;
+}
+
+void FCombatMelee::EndAttackWindow(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone)
+{
+	// ignore windows we didn't open
+	if (!Swing.IsActiveFor(DamageSourceBone))
+	{
+		return;
+	}
+
+	// cover the movement since the last tick before closing the swing
+	TickAttackWindow(Attacker, Swing, Settings, DamageSourceBone);
+
+	Swing.End();
+}
+
+void FCombatMelee::SweepMeleeAttack(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, const FVector& Start, const FVector& End)
+{
+	// only the server resolves hits. Clients play them from the combat event stream
+	if (!Attacker->HasAuthority())
+	{
+		return;
+	}
+
+	UWorld* World = Attacker->GetWorld();
+	UCombatDamageableSubsystem* DamageableSubsystem = World->GetSubsystem<UCombatDamageableSubsystem>();
+	UCombatDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UCombatDamageQueueSubsystem>();
+
+	// use the playing attack's damage and trace size if it has them
+	const FCombatCompiledAttack* CurrentAttack = GetCurrentAttack(Attacker, Settings.AttackSet);
+	const float TraceRadius = CurrentAttack ? CurrentAttack->TraceRadius : Settings.TraceRadius;
+	const float Damage = CurrentAttack ? CurrentAttack->Damage : Settings.Damage;
+
+	// find damageables touched by the attack, ignoring the attacker. Remote attackers hit what they saw, so rewind targets by their latency
+	TArray<FCombatDamageableHit> OutHits;
+
+	const int32 NumHits = Settings.RewindTime > 0.0f
+		? DamageableSubsystem->SweepDamageablesRewound(Start, End, TraceRadius, Settings.TargetTeams, Attacker, Settings.RewindTime, OutHits)
+		: DamageableSubsystem->SweepDamageables(Start, End, TraceRadius, Settings.TargetTeams, Attacker, OutHits);
+
+	if (NumHits == 0)
+	{
+		return;
+	}
+
+	ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(Attacker);
+
+	// iterate over each damageable hit
+	for (const FCombatDamageableHit& CurrentHit : OutHits)
+	{
+		// only damage each actor, or each prop of a field, once per swing
+		if (!Swing.AddHitActor(CurrentHit.Actor, CurrentHit.Item))
+		{
+			continue;
+		}
+
+		// knock upwards and away from the impact normal
+		const FVector Impulse = (CurrentHit.ImpactNormal * -Settings.KnockbackImpulse) + (FVector::UpVector * Settings.LaunchImpulse);
+
+		// queue the damage event, it will be applied to the actor after physics
+		DamageQueue->QueueDamage(CurrentHit.Actor, Damage, Attacker, CurrentHit.ImpactPoint, Impulse, CurrentHit.Item);
+
+		// let the attacker play its hit effects
+		if (AttackerInterface)
+		{
+			AttackerInterface->OnMeleeHit(CurrentHit.Actor, Damage, CurrentHit.ImpactPoint);
+		}
+	}
+}
+
+bool FCombatMelee::PlayAttackEvent(ACharacter* Attacker, const FCombatEvent& Event, UAnimMontage* ComboAttackMontage, UAnimMontage* ChargedAttackMontage)
+{
+	if (Event.Type != ECombatEventType::AttackStart && Event.Type != ECombatEventType::AttackSection)
+	{
+		return false;
+	}
+
+	UAnimMontage* Montage = Event.AttackMontage == 0 ? ComboAttackMontage : ChargedAttackMontage;
+
+	if (UAnimInstance* AnimInstance = Attacker->GetMesh()->GetAnimInstance())
+	{
+		if (Event.Type == ECombatEventType::AttackStart)
+		{
+			AnimInstance->Montage_Play(Montage);
+		}
+		else
+		{
+			UCombatAttackSet::JumpToSection(AnimInstance, Montage, Event.AttackSection);
+		}
+	}
+
+	return true;
+}
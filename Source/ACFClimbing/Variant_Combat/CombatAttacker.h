@@ -4,8 +4,117 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
+#include "UObject/ObjectKey.h"
+#include "CombatDamageableSubsystem.h"
 #include "CombatAttacker.generated.h"
 
+class ACharacter;
+class UAnimMontage;
+class UCombatAttackSet;
+class UCombatAttackTrajectories;
+struct FCombatCompiledAttack;
+struct FCombatEvent;
+
+/**
+ *  State of a single attack swing.
+ *  Tracks where the damage source was last swept from and which actors the swing already hit,
+ *  so each actor, or each damageable item of an actor, is damaged at most once per swing
+ */
+struct FCombatSwing
+{
+	/** Unique id of the swing. Zero while no swing is active */
+	uint32 SwingId = 0;
+
+	/** Bone or socket the swing sweeps from */
+	FName SourceBone;
+
+	/** Damage source location at the end of the last sweep */
+	FVector LastSourceLocation = FVector::ZeroVector;
+
+	/** Actors and items already hit in this swing. Whole actors use INDEX_NONE as their item */
+	TArray<TPair<TObjectKey<AActor>, int32>, TInlineAllocator<8>> HitActors;
+
+	/** Starts a new swing with a fresh id and an empty hit set */
+	void Begin(FName InSourceBone, const FVector& SourceLocation);
+
+	/** Ends the current swing */
+	void End();
+
+	/** Returns true if the actor, or its item, hasn't been hit in this swing yet, and records it */
+	bool AddHitActor(const AActor* Actor, int32 Item = INDEX_NONE);
+
+	/** Returns true while a swing is in progress */
+	bool IsActive() const { return SwingId != 0; }
+
+	/** Returns true while a swing from the given source is in progress */
+	bool IsActiveFor(FName InSourceBone) const { return IsActive() && SourceBone == InSourceBone; }
+};
+
+/**
+ *  Melee settings of an attacker.
+ *  Attackers keep these as their own properties and pass them to FCombatMelee on every call
+ */
+struct FCombatMeleeSettings
+{
+	/** Per-section attack settings. Optional */
+	const UCombatAttackSet* AttackSet = nullptr;
+
+	/** Baked damage source trajectories. Optional */
+	const UCombatAttackTrajectories* AttackTrajectories = nullptr;
+
+	/** Trace distance used when the playing section has no attack set entry */
+	float TraceDistance = 0.0f;
+
+	/** Trace radius used when the playing section has no attack set entry */
+	float TraceRadius = 0.0f;
+
+	/** Damage used when the playing section has no attack set entry */
+	float Damage = 0.0f;
+
+	/** Impulse applied away from the impact */
+	float KnockbackImpulse = 0.0f;
+
+	/** Upwards impulse applied on impact */
+	float LaunchImpulse = 0.0f;
+
+	/** Teams the attack can damage */
+	ECombatTeam TargetTeams = ECombatTeam::None;
+
+	/** How far back to rewind targets for lag compensation. Zero tests their current locations */
+	float RewindTime = 0.0f;
+};
+
+/**
+ *  Melee logic shared by the player character and enemies: damage source lookup, attack windows, hit sweeps and attack event playback.
+ *  Attackers own their settings and swing, and forward their ICombatAttacker calls here
+ */
+struct FCombatMelee
+{
+	/** Returns the damage source location from the baked trajectory of the playing montage, or from the mesh pose if it wasn't baked */
+	static FVector GetDamageSourceLocation(const ACharacter* Attacker, const UCombatAttackTrajectories* AttackTrajectories, FName DamageSourceBone);
+
+	/** Returns the attack set entry for the playing montage section, or nullptr if there's no attack set or the section isn't an attack */
+	static const FCombatCompiledAttack* GetCurrentAttack(const ACharacter* Attacker, const UCombatAttackSet* AttackSet);
+
+	/** Sweeps forward from the damage source. Outside of an attack window, the trace is a swing of its own */
+	static void DoAttackTrace(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone);
+
+	/** Starts a swing from the damage source's current location */
+	static void BeginAttackWindow(const ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone);
+
+	/** Sweeps the damage source's trajectory since the last tick */
+	static void TickAttackWindow(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone);
+
+	/** Sweeps the rest of the trajectory and ends the swing */
+	static void EndAttackWindow(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, FName DamageSourceBone);
+
+	/** Damages every target touched by a melee sphere swept from Start to End, skipping targets already hit in the swing. Only runs on the server */
+	static void SweepMeleeAttack(ACharacter* Attacker, FCombatSwing& Swing, const FCombatMeleeSettings& Settings, const FVector& Start, const FVector& End);
+
+	/** Plays an attack start or attack section event from the combat event stream. Returns false for other event types */
+	static bool PlayAttackEvent(ACharacter* Attacker, const FCombatEvent& Event, UAnimMontage* ComboAttackMontage, UAnimMontage* ChargedAttackMontage);
+};
+
 /**
  *  CombatAttacker Interface
  *  Provides common functionality to trigger attack animation events.
@@ -26,6 +135,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void DoAttackTrace(FName DamageSourceBone) = 0;
 
+	/** Starts a swing that continuously sweeps the damage source's trajectory. Usually called from a montage's AnimNotifyState */
+	UFUNCTION(BlueprintCallable, Category="Attacker")
+	virtual void BeginAttackWindow(FName DamageSourceBone) = 0;
+
+	/** Sweeps the damage source from its last position to its current one. Usually called from a montage's AnimNotifyState */
+	UFUNCTION(BlueprintCallable, Category="Attacker")
+	virtual void TickAttackWindow(FName DamageSourceBone) = 0;
+
+	/** Performs a final sweep and ends the swing. Usually called from a montage's AnimNotifyState */
+	UFUNCTION(BlueprintCallable, Category="Attacker")
+	virtual void EndAttackWindow(FName DamageSourceBone) = 0;
+
 	/** Performs a combo attack's check to continue the string. Usually called from a montage's AnimNotify */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckCombo() = 0;
@@ -33,4 +154,7 @@ public:
 	/** Performs a charged attack's check to loop the charge animation. Usually called from a montage's AnimNotify */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckChargedAttack() = 0;
+
+	/** Called on the server for every target damaged by one of this attacker's melee sweeps */
+	virtual void OnMeleeHit(AActor* Target, float Damage, const FVector& ImpactPoint) {}
 };
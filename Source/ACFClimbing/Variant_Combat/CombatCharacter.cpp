@@ -15,6 +15,14 @@
 #include "TimerManager.h"
 #include "Engine/LocalPlayer.h"
 #include "CombatPlayerController.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatAttackTrajectories.h"
+#include "CombatAttackSet.h"
+#include "CombatLifeBarSubsystem.h"
+#include "CombatRagdollSubsystem.h"
+#include "GameFramework/PlayerState.h"
+#include "CombatEventSubsystem.h"
+#include "Net/UnrealNetwork.h"
 
 DEFINE_LOG_CATEGORY(LogCombatCharacter);
 
@@ -120,6 +128,12 @@ void ACombatCharacter::DoLook(float Yaw, float Pitch)
 
 void ACombatCharacter::DoComboAttackStart()
 {
+	// remote players predict the attack locally, and the server runs it for real
+	if (!HasAuthority())
+	{
+		ServerComboAttackStart();
+	}
+
 	// are we already playing an attack animation?
 	if (bIsAttacking)
 	{
@@ -140,6 +154,12 @@ void ACombatCharacter::DoComboAttackEnd()
 
 void ACombatCharacter::DoChargedAttackStart()
 {
+	// remote players predict the attack locally, and the server runs it for real
+	if (!HasAuthority())
+	{
+		ServerChargedAttackStart();
+	}
+
 	// raise the charging attack flag
 	bIsChargingAttack = true;
 
@@ -156,6 +176,12 @@ void ACombatCharacter::DoChargedAttackStart()
 
 void ACombatCharacter::DoChargedAttackEnd()
 {
+	// release the charge on the server too
+	if (!HasAuthority())
+	{
+		ServerChargedAttackEnd();
+	}
+
 	// lower the charging attack flag
 	bIsChargingAttack = false;
 
@@ -166,13 +192,66 @@ void ACombatCharacter::DoChargedAttackEnd()
 	}
 }
 
+void ACombatCharacter::ServerComboAttackStart_Implementation()
+{
+	DoComboAttackStart();
+}
+
+void ACombatCharacter::ServerChargedAttackStart_Implementation()
+{
+	DoChargedAttackStart();
+}
+
+void ACombatCharacter::ServerChargedAttackEnd_Implementation()
+{
+	DoChargedAttackEnd();
+}
+
 void ACombatCharacter::ResetHP()
 {
 	// reset the current HP total
 	CurrentHP = MaxHP;
 
 	// update the life bar
-	LifeBarWidget->SetLifePercentage(1.0f);
+	SetLifeBarPercentage(1.0f);
+}
+
+void ACombatCharacter::SetLifeBarPercentage(float Percent)
+{
+	// push the value to whichever life bar we're using
+	if (bUseBatchedLifeBar)
+	{
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->SetLifePercentage(this, Percent);
+	}
+	else
+	{
+		LifeBarWidget->SetLifePercentage(Percent);
+	}
+}
+
+void ACombatCharacter::SetLifeBarVisible(bool bVisible)
+{
+	if (bUseBatchedLifeBar)
+	{
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->SetLifeBarVisible(this, bVisible);
+	}
+	else
+	{
+		LifeBar->SetHiddenInGame(!bVisible);
+	}
+}
+
+void ACombatCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the HUD draws our life bar, so make sure the widget component never creates or renders its widget
+	if (bUseBatchedLifeBar)
+	{
+		LifeBar->SetWidgetClass(nullptr);
+		LifeBar->SetVisibility(false);
+		LifeBar->SetComponentTickEnabled(false);
+	}
 }
 
 void ACombatCharacter::ComboAttack()
@@ -193,6 +272,9 @@ void ACombatCharacter::ComboAttack()
 		{
 			// set the end delegate for the montage
 			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
+
+			// play the attack on clients
+			GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackStart(this, 0);
 		}
 	}
 
@@ -216,6 +298,9 @@ void ACombatCharacter::ChargedAttack()
 		{
 			// set the end delegate for the montage
 			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
+
+			// play the attack on clients
+			GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackStart(this, 1);
 		}
 	}
 }
@@ -225,6 +310,9 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 	// reset the attacking flag
 	bIsAttacking = false;
 
+	// close any attack window left open by an interrupted montage
+	CurrentSwing.End();
+
 	// check if we have a non-stale cached input
 	if (GetWorld()->GetTimeSeconds() - CachedAttackInputTime <= AttackInputCacheTimeTolerance)
 	{
@@ -242,53 +330,73 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 	}
 }
 
-void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
+FCombatMeleeSettings ACombatCharacter::GetMeleeSettings() const
 {
-	// sweep for objects in front of the character to be hit by the attack
-	TArray<FHitResult> OutHits;
-
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
-	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+	FCombatMeleeSettings Settings;
+	Settings.AttackSet = AttackSet;
+	Settings.AttackTrajectories = AttackTrajectories;
+	Settings.TraceDistance = MeleeTraceDistance;
+	Settings.TraceRadius = MeleeTraceRadius;
+	Settings.Damage = MeleeDamage;
+	Settings.KnockbackImpulse = MeleeKnockbackImpulse;
+	Settings.LaunchImpulse = MeleeLaunchImpulse;
+
+	// the player hits enemies and neutral objects. Remote players attack what they saw, so rewind targets by their latency
+	Settings.TargetTeams = ECombatTeam::Enemy | ECombatTeam::Neutral;
+	Settings.RewindTime = GetLagCompensationRewindTime();
+
+	return Settings;
+}
 
-	// check for pawn and world dynamic collision object types
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
-	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
+{
+	FCombatMelee::DoAttackTrace(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	// use a sphere shape for the sweep
-	FCollisionShape CollisionShape;
-	CollisionShape.SetSphere(MeleeTraceRadius);
+void ACombatCharacter::BeginAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::BeginAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	// ignore self
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
+void ACombatCharacter::TickAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::TickAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-	if (GetWorld()->SweepMultiByObjectType(OutHits, TraceStart, TraceEnd, FQuat::Identity, ObjectParams, CollisionShape, QueryParams))
-	{
-		// iterate over each object hit
-		for (const FHitResult& CurrentHit : OutHits)
-		{
-			// check if we've hit a damageable actor
-			ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
+void ACombatCharacter::EndAttackWindow(FName DamageSourceBone)
+{
+	FCombatMelee::EndAttackWindow(this, CurrentSwing, GetMeleeSettings(), DamageSourceBone);
+}
 
-			if (Damageable)
-			{
-				// knock upwards and away from the impact normal
-				const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
+void ACombatCharacter::OnMeleeHit(AActor* Target, float Damage, const FVector& ImpactPoint)
+{
+	// call the BP handler to play effects, etc.
+	DealtDamage(Damage, ImpactPoint);
 
-				// pass the damage event to the actor
-				Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
+	// play the hit effects on clients
+	GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostHit(this, Target, Damage, ImpactPoint);
+}
 
-				// call the BP handler to play effects, etc.
-				DealtDamage(MeleeDamage, CurrentHit.ImpactPoint);
-			}
-		}
+float ACombatCharacter::GetLagCompensationRewindTime() const
+{
+	// only the server rewinds, and only for players on a remote connection
+	if (!bUseLagCompensation || !HasAuthority() || IsLocallyControlled() || !GetPlayerState())
+	{
+		return 0.0f;
 	}
+
+	// the client saw targets half a round trip plus its interpolation delay in the past
+	return GetPlayerState()->GetPingInMilliseconds() * 0.0005f + LagCompensationInterpDelay;
 }
 
 void ACombatCharacter::CheckCombo()
 {
+	// simulated proxies follow the server's sections from the combat event stream
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// are we playing a non-charge attack animation?
 	if (bIsAttacking && !bIsChargingAttack)
 	{
@@ -302,12 +410,16 @@ void ACombatCharacter::CheckCombo()
 			++ComboCount;
 
 			// do we still have a combo section to play?
-			if (ComboCount < ComboSectionNames.Num())
+			if (ComboCount < (AttackSet ? AttackSet->GetNumComboAttacks() : ComboSectionNames.Num()))
 			{
-				// jump to the next combo section
+				// jump to the next combo section. Attack sets already know the section index
 				if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 				{
-					AnimInstance->Montage_JumpToSection(ComboSectionNames[ComboCount], ComboAttackMontage);
+					const int32 SectionIndex = AttackSet ? AttackSet->GetComboAttack(ComboCount).SectionIndex : ComboAttackMontage->GetSectionIndex(ComboSectionNames[ComboCount]);
+					UCombatAttackSet::JumpToSection(AnimInstance, ComboAttackMontage, SectionIndex);
+
+					// jump to the same section on clients
+					GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackSection(this, 0, SectionIndex);
 				}
 			}
 		}
@@ -316,13 +428,26 @@ void ACombatCharacter::CheckCombo()
 
 void ACombatCharacter::CheckChargedAttack()
 {
+	// simulated proxies follow the server's sections from the combat event stream
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// raise the looped charged attack flag
 	bHasLoopedChargedAttack = true;
 
 	// jump to either the loop or the attack section depending on whether we're still holding the charge button
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
-		AnimInstance->Montage_JumpToSection(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection, ChargedAttackMontage);
+		const int32 SectionIndex = AttackSet
+			? (bIsChargingAttack ? AttackSet->GetChargeLoopSectionIndex() : AttackSet->GetChargeAttack().SectionIndex)
+			: ChargedAttackMontage->GetSectionIndex(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection);
+
+		UCombatAttackSet::JumpToSection(AnimInstance, ChargedAttackMontage, SectionIndex);
+
+		// jump to the same section on clients
+		GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostAttackSection(this, 1, SectionIndex);
 	}
 }
 
@@ -347,6 +472,9 @@ void ACombatCharacter::ApplyDamage(float Damage, AActor* DamageCauser, const FVe
 
 		// pass control to BP to play effects, etc.
 		ReceivedDamage(ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
+
+		// play the damage effects on clients
+		GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostDamage(this, ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
 	}
 
 }
@@ -356,17 +484,35 @@ void ACombatCharacter::HandleDeath()
 	// disable movement while we're dead
 	GetCharacterMovement()->DisableMovement();
 
-	// enable full ragdoll physics
-	GetMesh()->SetSimulatePhysics(true);
+	// ragdoll and pull the camera back. Clients play this when they see our HP reach zero
+	PlayDeathEffects();
+
+	// stop being a target while dead
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->UnregisterDamageable(this);
+
+	// schedule respawning
+	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &ACombatCharacter::RespawnCharacter, RespawnTime, false);
+}
+
+void ACombatCharacter::PlayDeathEffects()
+{
+	bShowingDeathEffects = true;
+
+	// enable full ragdoll physics if the ragdoll budget allows it
+	if (!GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StartRagdoll(GetMesh()))
+	{
+		// over budget, play the canned death animation instead
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			AnimInstance->Montage_Play(DeathMontage);
+		}
+	}
 
 	// hide the life bar
-	LifeBar->SetHiddenInGame(true);
+	SetLifeBarVisible(false);
 
 	// pull back the camera
 	GetCameraBoom()->TargetArmLength = DeathCameraDistance;
-
-	// schedule respawning
-	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &ACombatCharacter::RespawnCharacter, RespawnTime, false);
 }
 
 void ACombatCharacter::ApplyHealing(float Healing, AActor* Healer)
@@ -376,10 +522,135 @@ void ACombatCharacter::ApplyHealing(float Healing, AActor* Healer)
 
 void ACombatCharacter::RespawnCharacter()
 {
+	// reset in place at the Player Controller's checkpoint if we can
+	if (bRespawnInPlace)
+	{
+		if (ACombatPlayerController* PC = Cast<ACombatPlayerController>(GetController()))
+		{
+			ResetInPlace(PC->GetRespawnTransform());
+			return;
+		}
+	}
+
 	// destroy the character and let it be respawned by the Player Controller
 	Destroy();
 }
 
+void ACombatCharacter::ResetInPlace(const FTransform& RespawnTransform)
+{
+	// move to the respawn point, discarding any leftover physics state
+	SetActorTransform(RespawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+	// face the respawn direction
+	if (GetController())
+	{
+		GetController()->SetControlRotation(RespawnTransform.Rotator());
+	}
+
+	// restore movement
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	// reset HP to maximum. Clients play the respawn when they see it
+	ResetHP();
+
+	// restore the mesh, life bar and camera
+	PlayRespawnEffects();
+
+	// become a melee target again
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Player, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius(), GetCapsuleComponent()->GetScaledCapsuleHalfHeight_WithoutHemisphere());
+}
+
+void ACombatCharacter::PlayRespawnEffects()
+{
+	bShowingDeathEffects = false;
+
+	// stop the ragdoll. It detached the mesh, so reattach it and restore its transform
+	GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->ReleaseRagdoll(GetMesh());
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetPhysicsBlendWeight(0.0f);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	GetMesh()->SetRelativeTransform(MeshStartingTransform);
+
+	// stop the death animation and any attack in progress
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	bIsAttacking = false;
+	bIsChargingAttack = false;
+	bHasLoopedChargedAttack = false;
+	ComboCount = 0;
+	CachedAttackInputTime = 0.0f;
+	CurrentSwing.End();
+
+	// show and fill the life bar
+	SetLifeBarVisible(true);
+	SetLifeBarPercentage(CurrentHP / MaxHP);
+
+	// bring the camera back in
+	GetCameraBoom()->TargetArmLength = DefaultCameraDistance;
+}
+
+void ACombatCharacter::OnRep_CurrentHP()
+{
+	// the initial replication can arrive before BeginPlay sets up the life bar. BeginPlay applies it instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	// clients follow the server's HP here. The server updates its life bar as it takes damage
+	SetLifeBarPercentage(CurrentHP / MaxHP);
+
+	// HP is replicated state, so clients always end up agreeing with the server on whether we're dead
+	const bool bIsDead = CurrentHP <= 0.0f;
+
+	if (bIsDead != bShowingDeathEffects)
+	{
+		if (bIsDead)
+		{
+			PlayDeathEffects();
+		}
+		else
+		{
+			PlayRespawnEffects();
+		}
+	}
+}
+
+void ACombatCharacter::ReceiveCombatEvent(const FCombatEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case ECombatEventType::AttackStart:
+	case ECombatEventType::AttackSection:
+	{
+		// the owning client already predicted its own attacks
+		if (!IsLocallyControlled())
+		{
+			FCombatMelee::PlayAttackEvent(this, Event, ComboAttackMontage, ChargedAttackMontage);
+		}
+
+		break;
+	}
+
+	case ECombatEventType::Hit:
+
+		DealtDamage(Event.Damage, Event.Location);
+		break;
+
+	case ECombatEventType::Damage:
+
+		ReceivedDamage(Event.Damage, Event.Location, Event.Direction);
+		break;
+
+	default:
+		break;
+	}
+}
+
 float ACombatCharacter::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
 	// only process damage if the character is still alive
@@ -400,11 +671,10 @@ float ACombatCharacter::TakeDamage(float Damage, struct FDamageEvent const& Dama
 	else
 	{
 		// update the life bar
-		LifeBarWidget->SetLifePercentage(CurrentHP / MaxHP);
+		SetLifeBarPercentage(CurrentHP / MaxHP);
 
-		// enable partial ragdoll physics, but keep the pelvis vertical
-		GetMesh()->SetPhysicsBlendWeight(0.5f);
-		GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		// blend in partial ragdoll physics, but keep the pelvis vertical. Skipped if the ragdoll budget is full
+		GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StartHitReaction(GetMesh(), PelvisBoneName, HitReactionBlendWeight, HitReactionDuration);
 	}
 
 	// return the received damage amount
@@ -418,8 +688,8 @@ void ACombatCharacter::Landed(const FHitResult& Hit)
 	// is the character still alive?
 	if (CurrentHP >= 0.0f)
 	{
-		// disable ragdoll physics
-		GetMesh()->SetPhysicsBlendWeight(0.0f);
+		// end the hit reaction early
+		GetWorld()->GetSubsystem<UCombatRagdollSubsystem>()->StopHitReaction(GetMesh());
 	}
 }
 
@@ -427,21 +697,46 @@ void ACombatCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// get the life bar from the widget component
-	LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
-	check(LifeBarWidget);
-
 	// initialize the camera
 	GetCameraBoom()->TargetArmLength = DefaultCameraDistance;
 
 	// save the relative transform for the mesh so we can reset the ragdoll later
 	MeshStartingTransform = GetMesh()->GetRelativeTransform();
 
-	// set the life bar color
-	LifeBarWidget->SetBarColor(LifeBarColor);
+	// take the attack montages from the attack set
+	if (AttackSet)
+	{
+		ComboAttackMontage = AttackSet->GetComboAttackMontage();
+		ChargedAttackMontage = AttackSet->GetChargedAttackMontage();
+	}
 
-	// reset HP to maximum
-	ResetHP();
+	if (bUseBatchedLifeBar)
+	{
+		// add our life bar to the HUD, floating where the widget component is placed
+		GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>()->RegisterLifeBar(this, LifeBar->GetRelativeLocation(), LifeBarColor);
+	}
+	else
+	{
+		// get the life bar from the widget component
+		LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
+		check(LifeBarWidget);
+
+		// set the life bar color
+		LifeBarWidget->SetBarColor(LifeBarColor);
+	}
+
+	// reset HP to maximum. Clients apply the replicated value instead, in case we're already dead
+	if (HasAuthority())
+	{
+		ResetHP();
+	}
+	else
+	{
+		OnRep_CurrentHP();
+	}
+
+	// register as a damageable so melee attacks can find us
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Player, GetCapsuleComponent(), GetCapsuleComponent()->GetScaledCapsuleRadius(), GetCapsuleComponent()->GetScaledCapsuleHalfHeight_WithoutHemisphere());
 }
 
 void ACombatCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -450,6 +745,23 @@ void ACombatCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 	// clear the respawn timer
 	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+
+	// unregister from the damageable registry. The subsystem may already be gone during world teardown
+	if (UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>())
+	{
+		DamageableSubsystem->UnregisterDamageable(this);
+	}
+	// remove our life bar from the HUD. The subsystem may already be gone during world teardown
+	if (UCombatLifeBarSubsystem* LifeBarSubsystem = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBarSubsystem->UnregisterLifeBar(this);
+	}
+
+	// stop counting against the ragdoll budget
+	if (UCombatRagdollSubsystem* RagdollSubsystem = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+	{
+		RagdollSubsystem->ReleaseRagdoll(GetMesh());
+	}
 }
 
 void ACombatCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -486,3 +798,10 @@ void ACombatCharacter::NotifyControllerChanged()
 	}
 }
 
+void ACombatCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatCharacter, CurrentHP);
+}
+
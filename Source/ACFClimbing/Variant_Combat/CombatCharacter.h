@@ -6,6 +6,7 @@
 #include "GameFramework/Character.h"
 #include "CombatAttacker.h"
 #include "CombatDamageable.h"
+#include "CombatEventReceiver.h"
 #include "Animation/AnimInstance.h"
 #include "CombatCharacter.generated.h"
 
@@ -14,6 +15,9 @@ class UCameraComponent;
 class UInputAction;
 struct FInputActionValue;
 class UCombatLifeBar;
+class UCombatAttackTrajectories;
+class UCombatAttackSet;
+struct FCombatCompiledAttack;
 class UWidgetComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCombatCharacter, Log, All);
@@ -27,7 +31,7 @@ DECLARE_LOG_CATEGORY_EXTERN(LogCombatCharacter, Log, All);
  *  - Respawning
  */
 UCLASS(abstract)
-class ACombatCharacter : public ACharacter, public ICombatAttacker, public ICombatDamageable
+class ACombatCharacter : public ACharacter, public ICombatAttacker, public ICombatDamageable, public ICombatEventReceiver
 {
 	GENERATED_BODY()
 
@@ -73,8 +77,8 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 100))
 	float MaxHP = 5.0f;
 
-	/** Current amount of HP the character has */
-	UPROPERTY(VisibleAnywhere, Category="Damage")
+	/** Current amount of HP the character has. Replicated so clients can update the life bar */
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_CurrentHP, Category="Damage")
 	float CurrentHP = 0.0f;
 
 	/** Life bar widget fill color */
@@ -85,10 +89,22 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Damage")
 	FName PelvisBoneName;
 
+	/** Physics blend weight at the start of a hit reaction */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 1))
+	float HitReactionBlendWeight = 0.5f;
+
+	/** Time a hit reaction takes to blend back to animation */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float HitReactionDuration = 0.6f;
+
 	/** Pointer to the life bar widget */
 	UPROPERTY(EditAnywhere, Category="Damage")
 	TObjectPtr<UCombatLifeBar> LifeBarWidget;
 
+	/** If true, the life bar is drawn by the HUD together with every other life bar, instead of by the widget component */
+	UPROPERTY(EditAnywhere, Category="Damage")
+	bool bUseBatchedLifeBar = true;
+
 	/** Max amount of time that may elapse for a non-combo attack input to not be considered stale */
 	UPROPERTY(EditAnywhere, Category="Melee Attack", meta = (ClampMin = 0, ClampMax = 5))
 	float AttackInputCacheTimeTolerance = 1.0f;
@@ -107,6 +123,21 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace", meta = (ClampMin = 0, ClampMax = 200, Units = "cm"))
 	float MeleeTraceRadius = 75.0f;
 
+	/** Optional baked attack trajectories. Damage sources found here don't need an up to date mesh pose */
+	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace")
+	TObjectPtr<UCombatAttackTrajectories> AttackTrajectories;
+
+	/** If true, attacks from remote players are tested on the server against where targets were on the attacker's screen */
+	UPROPERTY(EditAnywhere, Category="Melee Attack|Lag Compensation")
+	bool bUseLagCompensation = true;
+
+	/** Time remote clients render other actors behind the server, added to half the ping when rewinding */
+	UPROPERTY(EditAnywhere, Category="Melee Attack|Lag Compensation", meta = (ClampMin = 0, ClampMax = 0.5, Units = "s"))
+	float LagCompensationInterpDelay = 0.1f;
+
+	/** Swing currently being resolved, so each target is only damaged once per swing */
+	FCombatSwing CurrentSwing;
+
 	/** Amount of damage a melee attack will deal */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Damage", meta = (ClampMin = 0, ClampMax = 100))
 	float MeleeDamage = 1.0f;
@@ -119,6 +150,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Damage", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm/s"))
 	float MeleeLaunchImpulse = 300.0f;
 
+	/** Optional attack set. When set, it replaces the montages and sections below, and sets the damage and trace size of each attack */
+	UPROPERTY(EditAnywhere, Category="Melee Attack")
+	TObjectPtr<UCombatAttackSet> AttackSet;
+
 	/** AnimMontage that will play for combo attacks */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Combo")
 	UAnimMontage* ComboAttackMontage;
@@ -160,10 +195,18 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Camera", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
 	float DefaultCameraDistance = 100.0f;
 
+	/** AnimMontage played on death when the ragdoll budget is full */
+	UPROPERTY(EditAnywhere, Category="Death")
+	UAnimMontage* DeathMontage;
+
 	/** Time to wait before respawning the character */
 	UPROPERTY(EditAnywhere, Category="Respawn", meta = (ClampMin = 0, ClampMax = 10))
 	float RespawnTime = 3.0f;
 
+	/** If true, the character is reset and teleported to the checkpoint on respawn instead of being destroyed and re-created */
+	UPROPERTY(EditAnywhere, Category="Respawn")
+	bool bRespawnInPlace = true;
+
 	/** Attack montage ended delegate */
 	FOnMontageEnded OnAttackMontageEnded;
 
@@ -223,9 +266,40 @@ public:
 
 protected:
 
+	/** Starts a combo attack on the server for a remote player */
+	UFUNCTION(Server, Reliable)
+	void ServerComboAttackStart();
+
+	/** Starts a charged attack on the server for a remote player */
+	UFUNCTION(Server, Reliable)
+	void ServerChargedAttackStart();
+
+	/** Releases a charged attack on the server for a remote player */
+	UFUNCTION(Server, Reliable)
+	void ServerChargedAttackEnd();
+
+	/** Updates the life bar on clients when HP replicates, and plays death or respawn when HP crosses zero */
+	UFUNCTION()
+	void OnRep_CurrentHP();
+
+	/** Ragdolls or plays the death animation and pulls the camera back. Cosmetic, shared by the server and clients */
+	void PlayDeathEffects();
+
+	/** Undoes the death effects, restoring the mesh, life bar and camera. Cosmetic, shared by the server and clients */
+	void PlayRespawnEffects();
+
+	/** If true, the death effects are showing */
+	bool bShowingDeathEffects = false;
+
 	/** Resets the character's current HP to maximum */
 	void ResetHP();
 
+	/** Sets the life bar to the provided 0-1 percentage value */
+	void SetLifeBarPercentage(float Percent);
+
+	/** Shows or hides the life bar */
+	void SetLifeBarVisible(bool bVisible);
+
 	/** Performs a combo attack */
 	void ComboAttack();
 
@@ -235,6 +309,12 @@ protected:
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Returns the melee settings passed to the shared melee code */
+	FCombatMeleeSettings GetMeleeSettings() const;
+
+	/** Returns how far back the server should rewind targets for this character's attacks, or zero if no rewind is needed */
+	float GetLagCompensationRewindTime() const;
+
 	
 public:
 
@@ -243,6 +323,18 @@ public:
 	/** Performs the collision check for an attack */
 	virtual void DoAttackTrace(FName DamageSourceBone) override;
 
+	/** Starts a swing that sweeps the damage source's trajectory */
+	virtual void BeginAttackWindow(FName DamageSourceBone) override;
+
+	/** Sweeps the damage source from its last position to its current one */
+	virtual void TickAttackWindow(FName DamageSourceBone) override;
+
+	/** Performs a final sweep and ends the swing */
+	virtual void EndAttackWindow(FName DamageSourceBone) override;
+
+	/** Plays the hit effects for a target damaged by a melee sweep */
+	virtual void OnMeleeHit(AActor* Target, float Damage, const FVector& ImpactPoint) override;
+
 	/** Performs the combo string check */
 	virtual void CheckCombo() override;
 
@@ -264,9 +356,19 @@ public:
 
 	// ~end CombatDamageable interface
 
-	/** Called from the respawn timer to destroy and re-create the character */
+	/** Called from the respawn timer to reset the character at the checkpoint, or destroy it so it's re-created */
 	void RespawnCharacter();
 
+	/** Brings the character back to life at the given transform, keeping its controller, camera and widgets */
+	void ResetInPlace(const FTransform& RespawnTransform);
+
+	// ~begin CombatEventReceiver interface
+
+	/** Plays the effects of a combat event received from the server */
+	virtual void ReceiveCombatEvent(const FCombatEvent& Event) override;
+
+	// ~end CombatEventReceiver interface
+
 public:
 
 	/** Overrides the default TakeDamage functionality */
@@ -287,6 +389,9 @@ protected:
 
 protected:
 
+	/** Disables the life bar widget if the batched life bar is used */
+	virtual void PostInitializeComponents() override;
+
 	/** Initialization */
 	virtual void BeginPlay() override;
 
@@ -299,6 +404,9 @@ protected:
 	/** Handles possessed initialization */
 	virtual void NotifyControllerChanged() override;
 
+	/** Registers replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 public:
 
 	/** Returns CameraBoom subobject **/
@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatDamageQueueSubsystem.h"
+#include "CombatDamageable.h"
+#include "CombatDamageableSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+
+void FCombatDamageQueueTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->ResolveQueuedDamage();
+	}
+}
+
+FString FCombatDamageQueueTickFunction::DiagnosticMessage()
+{
+	return TEXT("FCombatDamageQueueTickFunction");
+}
+
+void UCombatDamageQueueSubsystem::QueueDamage(AActor* Target, float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse, int32 Item)
+{
+	check(Target);
+
+	// items are keyed separately, so hits on different props of the same field don't merge
+	const TTuple<const AActor*, const AActor*, int32> DamageKey(DamageCauser, Target, Item);
+
+	// merge with any damage this causer already queued on this target
+	if (const int32* QueuedIndex = QueuedDamageIndices.Find(DamageKey))
+	{
+		FCombatQueuedDamage& Queued = QueuedDamage[*QueuedIndex];
+		Queued.Damage += Damage;
+		Queued.DamageImpulse += DamageImpulse;
+		return;
+	}
+
+	// otherwise queue a new event
+	FCombatQueuedDamage& Queued = QueuedDamage.AddDefaulted_GetRef();
+	Queued.Target = Target;
+	Queued.DamageCauser = DamageCauser;
+	Queued.Item = Item;
+	Queued.Damage = Damage;
+	Queued.DamageLocation = DamageLocation;
+	Queued.DamageImpulse = DamageImpulse;
+
+	QueuedDamageIndices.Add(DamageKey, QueuedDamage.Num() - 1);
+}
+
+void UCombatDamageQueueSubsystem::ResolveQueuedDamage()
+{
+	if (QueuedDamage.IsEmpty())
+	{
+		return;
+	}
+
+	// take the queue so damage caused by this pass, e.g. from death events, lands next frame
+	Swap(ResolvingDamage, QueuedDamage);
+	QueuedDamageIndices.Reset();
+
+	const UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>();
+
+	// apply the damage in the order it was queued so results are deterministic
+	for (const FCombatQueuedDamage& Queued : ResolvingDamage)
+	{
+		// skip targets that were destroyed or stopped being damageable since the hit
+		AActor* Target = Queued.Target.Get();
+		ICombatDamageable* Damageable = Target ? DamageableSubsystem->FindDamageable(Target) : nullptr;
+
+		if (!Damageable)
+		{
+			continue;
+		}
+
+		if (Queued.Item != INDEX_NONE)
+		{
+			Damageable->ApplyItemDamage(Queued.Item, Queued.Damage, Queued.DamageCauser.Get(), Queued.DamageLocation, Queued.DamageImpulse);
+		}
+		else
+		{
+			Damageable->ApplyDamage(Queued.Damage, Queued.DamageCauser.Get(), Queued.DamageLocation, Queued.DamageImpulse);
+		}
+	}
+
+	ResolvingDamage.Reset();
+}
+
+void UCombatDamageQueueSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// resolve after physics, once attacks from anim notifies have been queued
+	ResolveTickFunction.bCanEverTick = true;
+	ResolveTickFunction.TickGroup = TG_PostPhysics;
+	ResolveTickFunction.Target = this;
+	ResolveTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UCombatDamageQueueSubsystem::Deinitialize()
+{
+	// stop resolving
+	if (ResolveTickFunction.IsTickFunctionRegistered())
+	{
+		ResolveTickFunction.UnRegisterTickFunction();
+	}
+
+	ResolveTickFunction.Target = nullptr;
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatDamageQueueSubsystem.generated.h"
+
+class UCombatDamageQueueSubsystem;
+
+/**
+ *  A damage event waiting to be resolved
+ */
+struct FCombatQueuedDamage
+{
+	/** Actor receiving the damage */
+	TWeakObjectPtr<AActor> Target;
+
+	/** Actor dealing the damage */
+	TWeakObjectPtr<AActor> DamageCauser;
+
+	/** Damageable item of the target that was hit, or INDEX_NONE to damage the whole target */
+	int32 Item = INDEX_NONE;
+
+	/** Total damage from this causer to this target this frame */
+	float Damage = 0.0f;
+
+	/** Location of the first hit */
+	FVector DamageLocation = FVector::ZeroVector;
+
+	/** Total knockback impulse */
+	FVector DamageImpulse = FVector::ZeroVector;
+};
+
+/**
+ *  Tick function that resolves the damage queue at a fixed point in the frame
+ */
+USTRUCT()
+struct FCombatDamageQueueTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Subsystem to resolve */
+	UCombatDamageQueueSubsystem* Target = nullptr;
+
+	/** Resolves the queued damage */
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	/** Describes the tick function for debugging */
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatDamageQueueTickFunction> : public TStructOpsTypeTraitsBase2<FCombatDamageQueueTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ *  Collects combat damage during the frame and applies it in one batched pass after physics.
+ *  Damage from the same causer to the same target or item is merged, so each pair is only resolved once per frame,
+ *  and nothing dies or broadcasts from inside an anim notify
+ */
+UCLASS()
+class UCombatDamageQueueSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Damage events in the order they were first queued */
+	TArray<FCombatQueuedDamage> QueuedDamage;
+
+	/** Maps each causer, target and item to its queued damage index */
+	TMap<TTuple<const AActor*, const AActor*, int32>, int32> QueuedDamageIndices;
+
+	/** Damage being resolved. Kept around to reuse its allocation */
+	TArray<FCombatQueuedDamage> ResolvingDamage;
+
+	/** Resolves the queue once per frame */
+	FCombatDamageQueueTickFunction ResolveTickFunction;
+
+public:
+
+	/** Queues damage to be applied to the target, or one of its damageable items, later this frame */
+	void QueueDamage(AActor* Target, float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse, int32 Item = INDEX_NONE);
+
+	/** Applies all queued damage. Damage queued while resolving is applied next frame */
+	void ResolveQueuedDamage();
+
+	/** Registers the resolve tick */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Unregisters the resolve tick */
+	virtual void Deinitialize() override;
+};
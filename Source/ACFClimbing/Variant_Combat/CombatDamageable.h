@@ -33,4 +33,10 @@ public:
 	/** Handles healing events */
 	UFUNCTION(BlueprintCallable, Category="Damageable")
 	virtual void ApplyHealing(float Healing, AActor* Healer) = 0;
+
+	/** Handles damage to one of the damageable items the actor registered. Damages the whole actor by default */
+	virtual void ApplyItemDamage(int32 Item, float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
+	{
+		ApplyDamage(Damage, DamageCauser, DamageLocation, DamageImpulse);
+	}
 };
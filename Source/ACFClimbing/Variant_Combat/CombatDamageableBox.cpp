@@ -5,6 +5,9 @@
 #include "Components/StaticMeshComponent.h"
 #include "TimerManager.h"
 #include "Engine/World.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatEventSubsystem.h"
+#include "Net/UnrealNetwork.h"
 
 ACombatDamageableBox::ACombatDamageableBox()
 {
@@ -21,6 +24,10 @@ ACombatDamageableBox::ACombatDamageableBox()
 
 	// disable navigation relevance so boxes don't affect NavMesh generation
 	Mesh->bNavigationRelevant = false;
+
+	// replicate HP and the simulated movement
+	bReplicates = true;
+	SetReplicatingMovement(true);
 }
 
 void ACombatDamageableBox::RemoveFromLevel()
@@ -29,12 +36,32 @@ void ACombatDamageableBox::RemoveFromLevel()
 	Destroy();
 }
 
+void ACombatDamageableBox::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// register as a damageable so melee attacks can find us
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Neutral, Mesh, Mesh->Bounds.SphereRadius);
+
+	// apply the HP that replicated before we began play
+	if (!HasAuthority())
+	{
+		OnRep_CurrentHP();
+	}
+}
+
 void ACombatDamageableBox::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
 	// clear the death timer
 	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// unregister from the damageable registry. The subsystem may already be gone during world teardown
+	if (UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>())
+	{
+		DamageableSubsystem->UnregisterDamageable(this);
+	}
 }
 
 void ACombatDamageableBox::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
@@ -56,6 +83,9 @@ void ACombatDamageableBox::ApplyDamage(float Damage, AActor* DamageCauser, const
 
 		// call the BP handler to play effects, etc.
 		OnBoxDamaged(DamageLocation, DamageImpulse);
+
+		// play the damage effects on clients
+		GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostDamage(this, Damage, DamageLocation, DamageImpulse.GetSafeNormal());
 	}
 }
 
@@ -64,6 +94,9 @@ void ACombatDamageableBox::HandleDeath()
 	// change the collision object type to Visibility so we ignore most interactions but still retain physics collisions
 	Mesh->SetCollisionObjectType(ECC_Visibility);
 
+	// stop being a melee target
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->UnregisterDamageable(this);
+
 	// call the BP handler to play effects, etc.
 	OnBoxDestroyed();
 
@@ -76,3 +109,41 @@ void ACombatDamageableBox::ApplyHealing(float Healing, AActor* Healer)
 	// stub
 }
 
+void ACombatDamageableBox::ReceiveCombatEvent(const FCombatEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case ECombatEventType::Damage:
+
+		// the impulse strength isn't sent, only its direction
+		OnBoxDamaged(Event.Location, Event.Direction);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ACombatDamageableBox::OnRep_CurrentHP()
+{
+	// the initial replication can arrive before BeginPlay. BeginPlay applies it instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	// HP only goes down, so this runs once per client, even for clients that join after the box broke
+	if (CurrentHP <= 0.0f)
+	{
+		// match the server's collision so the debris behaves the same
+		Mesh->SetCollisionObjectType(ECC_Visibility);
+		OnBoxDestroyed();
+	}
+}
+
+void ACombatDamageableBox::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatDamageableBox, CurrentHP);
+}
@@ -5,13 +5,14 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "CombatDamageable.h"
+#include "CombatEventReceiver.h"
 #include "CombatDamageableBox.generated.h"
 
 /**
  *  A simple physics box that reacts to damage through the ICombatDamageable interface
  */
 UCLASS(abstract)
-class ACombatDamageableBox : public AActor, public ICombatDamageable
+class ACombatDamageableBox : public AActor, public ICombatDamageable, public ICombatEventReceiver
 {
 	GENERATED_BODY()
 	
@@ -26,8 +27,8 @@ public:
 
 protected:
 
-	/** Amount of HP this box starts with. */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Damage")
+	/** Amount of HP this box starts with. Replicated so clients can play the destruction */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, ReplicatedUsing=OnRep_CurrentHP, Category="Damage")
 	float CurrentHP = 3.0f;
 
 	/** Time to wait before we remove this box from the level. */
@@ -47,8 +48,15 @@ protected:
 	/** Timer callback to remove the box from the level after it dies */
 	void RemoveFromLevel();
 
+	/** Plays the destruction on clients when HP runs out */
+	UFUNCTION()
+	void OnRep_CurrentHP();
+
 public:
 
+	/** Initialization */
+	virtual void BeginPlay() override;
+
 	/** EndPlay cleanup */
 	void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
@@ -64,4 +72,14 @@ public:
 	virtual void ApplyHealing(float Healing, AActor* Healer) override;
 
 	// ~End CombatDamageable interface
+
+	// ~Begin CombatEventReceiver interface
+
+	/** Plays the effects of a combat event received from the server */
+	virtual void ReceiveCombatEvent(const FCombatEvent& Event) override;
+
+	// ~End CombatEventReceiver interface
+
+	/** Registers replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 };
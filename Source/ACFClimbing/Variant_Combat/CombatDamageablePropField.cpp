@@ -0,0 +1,463 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatDamageablePropField.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatEventSubsystem.h"
+#include "Net/UnrealNetwork.h"
+
+ACombatDamageablePropField::ACombatDamageablePropField()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// create the instanced mesh
+	RootComponent = Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Instances"));
+
+	// set the collision properties
+	Instances->SetCollisionProfileName(FName("BlockAllDynamic"));
+
+	// disable navigation relevance so props don't affect NavMesh generation
+	Instances->bNavigationRelevant = false;
+
+	// replicate destroyed props
+	bReplicates = true;
+}
+
+void ACombatDamageablePropField::BeginPlay()
+{
+	Super::BeginPlay();
+
+	const int32 NumProps = Instances->GetInstanceCount();
+
+	PropHPs.Init(PropMaxHP, NumProps);
+	PropBodies.Init(INDEX_NONE, NumProps);
+	PropInstances.SetNumUninitialized(NumProps);
+	InstanceProps.SetNumUninitialized(NumProps);
+	PropLocations.SetNumUninitialized(NumProps);
+
+	const FBoxSphereBounds MeshBounds = Instances->GetStaticMesh() ? Instances->GetStaticMesh()->GetBounds() : FBoxSphereBounds(ForceInit);
+	PropMeshOrigin = MeshBounds.Origin;
+
+	UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>();
+
+	for (int32 i = 0; i < NumProps; ++i)
+	{
+		// every instance starts as its own prop
+		PropInstances[i] = i;
+		InstanceProps[i] = i;
+
+		FTransform InstanceTransform;
+		Instances->GetInstanceTransform(i, InstanceTransform, true);
+
+		PropLocations[i] = InstanceTransform.TransformPosition(MeshBounds.Origin);
+		PropRadius = FMath::Max(PropRadius, MeshBounds.SphereRadius * InstanceTransform.GetMaximumAxisScale());
+	}
+
+	// register every prop as a damageable item so melee attacks can find it
+	for (int32 i = 0; i < NumProps; ++i)
+	{
+		DamageableSubsystem->RegisterDamageableItem(this, i, ECombatTeam::Neutral, nullptr, PropLocations[i], PropRadius);
+	}
+
+	// remove and move the props changed before we began play
+	if (!HasAuthority())
+	{
+		OnRep_DestroyedProps();
+		OnRep_PropRestTransforms();
+	}
+}
+
+void ACombatDamageablePropField::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// unregister every prop from the damageable registry. The subsystem may already be gone during world teardown
+	if (UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>())
+	{
+		DamageableSubsystem->UnregisterDamageable(this);
+	}
+}
+
+int32 ACombatDamageablePropField::GetNumLiveProps() const
+{
+	int32 NumLive = 0;
+
+	for (const float HP : PropHPs)
+	{
+		NumLive += HP > 0.0f ? 1 : 0;
+	}
+
+	return NumLive;
+}
+
+void ACombatDamageablePropField::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
+{
+	// the hit prop isn't known. Impact points are on the prop's bounds, so it's the closest one
+	ApplyItemDamage(FindPropAt(DamageLocation), Damage, DamageCauser, DamageLocation, DamageImpulse);
+}
+
+void ACombatDamageablePropField::ApplyItemDamage(int32 Item, float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
+{
+	// props are registered with their index as the item
+	const int32 Prop = Item;
+
+	// ignore props that were destroyed since the hit
+	if (!PropHPs.IsValidIndex(Prop) || PropHPs[Prop] <= 0.0f)
+	{
+		return;
+	}
+
+	// apply the damage
+	PropHPs[Prop] -= Damage;
+
+	// apply a physics impulse to the prop, ignoring its mass, if the physics budget lets it move
+	if (PropBodies[Prop] != INDEX_NONE || PromoteProp(Prop))
+	{
+		UStaticMeshComponent* Body = Bodies[PropBodies[Prop]];
+		Body->AddImpulseAtLocation(DamageImpulse * Body->GetMass(), DamageLocation);
+	}
+
+	// call the BP handler to play effects, etc.
+	OnPropDamaged(DamageLocation, DamageImpulse);
+
+	// play the damage effects on clients
+	GetWorld()->GetSubsystem<UCombatEventSubsystem>()->PostDamage(this, Damage, DamageLocation, DamageImpulse.GetSafeNormal());
+
+	// is the prop dead?
+	if (PropHPs[Prop] <= 0.0f)
+	{
+		DestroyProp(Prop);
+	}
+}
+
+void ACombatDamageablePropField::HandleDeath()
+{
+	// destroy every prop left in the field
+	for (int32 Prop = 0; Prop < PropHPs.Num(); ++Prop)
+	{
+		if (PropHPs[Prop] > 0.0f)
+		{
+			DestroyProp(Prop);
+		}
+	}
+}
+
+void ACombatDamageablePropField::ApplyHealing(float Healing, AActor* Healer)
+{
+	// stub
+}
+
+void ACombatDamageablePropField::ReceiveCombatEvent(const FCombatEvent& Event)
+{
+	if (Event.Type != ECombatEventType::Damage)
+	{
+		return;
+	}
+
+	// knock the same prop around locally, for looks only. It snaps to the server's rest transform once that replicates.
+	// The impulse strength isn't sent, only its direction
+	const int32 Prop = FindPropAt(Event.Location);
+
+	if (Prop != INDEX_NONE && (PropBodies[Prop] != INDEX_NONE || PromoteProp(Prop)))
+	{
+		UStaticMeshComponent* Body = Bodies[PropBodies[Prop]];
+		Body->AddImpulseAtLocation(Event.Direction * ClientImpulseStrength * Body->GetMass(), Event.Location);
+	}
+
+	OnPropDamaged(Event.Location, Event.Direction);
+}
+
+void ACombatDamageablePropField::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatDamageablePropField, DestroyedProps);
+	DOREPLIFETIME(ACombatDamageablePropField, PropRestTransforms);
+}
+
+int32 ACombatDamageablePropField::FindPropAt(const FVector& Location) const
+{
+	int32 ClosestProp = INDEX_NONE;
+	float ClosestDistanceSquared = FMath::Square(PropRadius * 1.5f);
+
+	for (int32 Prop = 0; Prop < PropHPs.Num(); ++Prop)
+	{
+		if (PropHPs[Prop] <= 0.0f)
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(GetPropLocation(Prop), Location);
+
+		if (DistanceSquared < ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			ClosestProp = Prop;
+		}
+	}
+
+	return ClosestProp;
+}
+
+FVector ACombatDamageablePropField::GetPropLocation(int32 Prop) const
+{
+	const int32 BodySlot = PropBodies[Prop];
+	return BodySlot != INDEX_NONE ? Bodies[BodySlot]->Bounds.Origin : PropLocations[Prop];
+}
+
+bool ACombatDamageablePropField::PromoteProp(int32 Prop)
+{
+	// only instanced props can be promoted
+	if (PropInstances[Prop] == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const int32 BodySlot = GetFreeBody();
+
+	if (BodySlot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// take the prop out of the instanced mesh
+	FTransform PropTransform;
+	Instances->GetInstanceTransform(PropInstances[Prop], PropTransform, true);
+	RemovePropInstance(Prop);
+
+	// put the body where the instance was and start simulating
+	UStaticMeshComponent* Body = Bodies[BodySlot];
+	Body->SetWorldTransform(PropTransform, false, nullptr, ETeleportType::ResetPhysics);
+	Body->SetCollisionObjectType(Instances->GetCollisionObjectType());
+	Body->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	Body->SetVisibility(true);
+	Body->SetSimulatePhysics(true);
+
+	BodyProps[BodySlot] = Prop;
+	PropBodies[Prop] = BodySlot;
+
+	// let the registry follow the body while it moves
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageableItem(this, Prop, ECombatTeam::Neutral, Body, FVector::ZeroVector, PropRadius);
+
+	return true;
+}
+
+void ACombatDamageablePropField::DestroyProp(int32 Prop)
+{
+	const FVector PropLocation = GetPropLocation(Prop);
+
+	PropHPs[Prop] = 0.0f;
+
+	// stop being a melee target
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->UnregisterDamageableItem(this, Prop);
+
+	if (PropBodies[Prop] != INDEX_NONE)
+	{
+		// change the collision object type to Visibility so we ignore most interactions but still retain physics collisions.
+		// The body is freed once it falls asleep
+		Bodies[PropBodies[Prop]]->SetCollisionObjectType(ECC_Visibility);
+	}
+	else if (PropInstances[Prop] != INDEX_NONE)
+	{
+		// no physics budget, just remove the instance
+		RemovePropInstance(Prop);
+	}
+
+	// call the BP handler to play effects, etc.
+	OnPropDestroyed(PropLocation);
+
+	// tell clients to remove the prop
+	if (HasAuthority())
+	{
+		DestroyedProps.Add(Prop);
+	}
+}
+
+void ACombatDamageablePropField::RemovePropInstance(int32 Prop)
+{
+	const int32 Instance = PropInstances[Prop];
+
+	// removing an instance shifts down every instance after it, so fix up their props
+	Instances->RemoveInstance(Instance);
+	InstanceProps.RemoveAt(Instance);
+
+	for (int32 i = Instance; i < InstanceProps.Num(); ++i)
+	{
+		PropInstances[InstanceProps[i]] = i;
+	}
+
+	PropInstances[Prop] = INDEX_NONE;
+}
+
+int32 ACombatDamageablePropField::GetFreeBody()
+{
+	// reuse a free body if we have one
+	const int32 FreeSlot = BodyProps.IndexOfByKey(INDEX_NONE);
+
+	if (FreeSlot != INDEX_NONE)
+	{
+		return FreeSlot;
+	}
+
+	// is the physics budget full?
+	if (Bodies.Num() >= MaxSimulatedProps)
+	{
+		return INDEX_NONE;
+	}
+
+	// create a new body matching the instanced mesh
+	UStaticMeshComponent* Body = NewObject<UStaticMeshComponent>(this);
+	Body->SetStaticMesh(Instances->GetStaticMesh());
+
+	for (int32 i = 0; i < Instances->GetNumMaterials(); ++i)
+	{
+		Body->SetMaterial(i, Instances->GetMaterial(i));
+	}
+
+	Body->SetCollisionProfileName(Instances->GetCollisionProfileName());
+	Body->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Body->SetVisibility(false);
+	Body->bNavigationRelevant = false;
+
+	// we need to know when the body settles to put it back in the field
+	Body->BodyInstance.bGenerateWakeEvents = true;
+	Body->OnComponentSleep.AddDynamic(this, &ACombatDamageablePropField::OnBodySleep);
+
+	Body->RegisterComponent();
+
+	Bodies.Add(Body);
+	return BodyProps.Add(INDEX_NONE);
+}
+
+void ACombatDamageablePropField::ReleaseBody(int32 BodySlot)
+{
+	UStaticMeshComponent* Body = Bodies[BodySlot];
+	Body->SetSimulatePhysics(false);
+	Body->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Body->SetVisibility(false);
+
+	PropBodies[BodyProps[BodySlot]] = INDEX_NONE;
+	BodyProps[BodySlot] = INDEX_NONE;
+}
+
+void ACombatDamageablePropField::OnBodySleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	const int32 BodySlot = Bodies.IndexOfByKey(SleepingComponent);
+
+	if (BodySlot == INDEX_NONE || BodyProps[BodySlot] == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 Prop = BodyProps[BodySlot];
+
+	// put live props back in the instanced mesh where they settled
+	if (PropHPs[Prop] > 0.0f)
+	{
+		const FTransform RestTransform = Bodies[BodySlot]->GetComponentTransform();
+
+		PlacePropInstance(Prop, RestTransform);
+
+		// tell clients where the prop ended up. Their own simulation of it only plays for looks
+		if (HasAuthority())
+		{
+			FCombatPropRestTransform* PropRest = PropRestTransforms.FindByPredicate([Prop](const FCombatPropRestTransform& Candidate) { return Candidate.Prop == Prop; });
+
+			if (!PropRest)
+			{
+				PropRest = &PropRestTransforms.AddDefaulted_GetRef();
+				PropRest->Prop = Prop;
+			}
+
+			PropRest->Transform = RestTransform;
+		}
+	}
+
+	// destroyed props simply disappear once their debris settles
+	ReleaseBody(BodySlot);
+}
+
+void ACombatDamageablePropField::PlacePropInstance(int32 Prop, const FTransform& PropTransform)
+{
+	// move the instance if the prop has one, otherwise add it back to the instanced mesh
+	if (PropInstances[Prop] != INDEX_NONE)
+	{
+		Instances->UpdateInstanceTransform(PropInstances[Prop], PropTransform, true, true);
+	}
+	else
+	{
+		PropInstances[Prop] = Instances->AddInstance(PropTransform, true);
+		InstanceProps.Add(Prop);
+	}
+
+	PropLocations[Prop] = PropTransform.TransformPosition(PropMeshOrigin);
+
+	// the registry can stop following the body
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageableItem(this, Prop, ECombatTeam::Neutral, nullptr, PropLocations[Prop], PropRadius);
+}
+
+void ACombatDamageablePropField::OnRep_DestroyedProps()
+{
+	// the initial replication can arrive before BeginPlay sets up the props. BeginPlay applies it instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	// remove the props destroyed since the last update
+	for (int32 i = NumDestroyedPropsApplied; i < DestroyedProps.Num(); ++i)
+	{
+		const int32 Prop = DestroyedProps[i];
+
+		if (PropHPs.IsValidIndex(Prop) && PropHPs[Prop] > 0.0f)
+		{
+			DestroyProp(Prop);
+		}
+	}
+
+	NumDestroyedPropsApplied = DestroyedProps.Num();
+}
+
+void ACombatDamageablePropField::OnRep_PropRestTransforms()
+{
+	// the initial replication can arrive before BeginPlay sets up the props. BeginPlay applies it instead
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	for (const FCombatPropRestTransform& PropRest : PropRestTransforms)
+	{
+		const int32 Prop = PropRest.Prop;
+
+		// destroyed props are handled by OnRep_DestroyedProps
+		if (!PropHPs.IsValidIndex(Prop) || PropHPs[Prop] <= 0.0f)
+		{
+			continue;
+		}
+
+		// skip props that are already where the server left them
+		if (PropInstances[Prop] != INDEX_NONE)
+		{
+			FTransform InstanceTransform;
+			Instances->GetInstanceTransform(PropInstances[Prop], InstanceTransform, true);
+
+			if (InstanceTransform.Equals(PropRest.Transform))
+			{
+				continue;
+			}
+		}
+
+		// stop the local simulation and snap to the server's rest transform
+		if (PropBodies[Prop] != INDEX_NONE)
+		{
+			ReleaseBody(PropBodies[Prop]);
+		}
+
+		PlacePropInstance(Prop, PropRest.Transform);
+	}
+}
@@ -0,0 +1,188 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CombatDamageable.h"
+#include "CombatEventReceiver.h"
+#include "CombatDamageablePropField.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMeshComponent;
+
+/**
+ *  Where a prop came to rest on the server after being knocked around
+ */
+USTRUCT()
+struct FCombatPropRestTransform
+{
+	GENERATED_BODY()
+
+	/** Prop that moved */
+	UPROPERTY()
+	int32 Prop = INDEX_NONE;
+
+	/** Instance transform the prop settled at */
+	UPROPERTY()
+	FTransform Transform;
+};
+
+/**
+ *  A field of damageable props drawn through a single instanced mesh.
+ *  Each instance placed on the mesh is a prop with its own HP. Props are registered with the damageable registry as items,
+ *  and hits are resolved to the closest prop to the impact point. Only props that get hit are promoted to simulated
+ *  physics bodies, and they're returned to the instanced mesh once they fall asleep, so untouched props cost a single draw.
+ *  Clients knock props around locally for looks, then snap them to where they settled on the server
+ *  Melee swings damage every prop they touch once, like separate actors
+ */
+UCLASS(abstract)
+class ACombatDamageablePropField : public AActor, public ICombatDamageable, public ICombatEventReceiver
+{
+	GENERATED_BODY()
+
+	/** Instanced prop mesh. Every instance placed in the editor becomes a prop */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* Instances;
+
+public:
+
+	/** Constructor */
+	ACombatDamageablePropField();
+
+protected:
+
+	/** Amount of HP each prop starts with */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Damage")
+	float PropMaxHP = 3.0f;
+
+	/** Maximum number of props simulating physics at once. Props hit while the budget is full take damage without moving */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Damage", meta = (ClampMin = 0, ClampMax = 64))
+	int32 MaxSimulatedProps = 8;
+
+	/** Impulse strength clients use to knock props around when playing damage events, since only the direction is sent */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Damage", meta = (ClampMin = 0, Units = "cm/s"))
+	float ClientImpulseStrength = 300.0f;
+
+	/** HP of each prop */
+	TArray<float> PropHPs;
+
+	/** Instance index of each prop, or INDEX_NONE while it's simulating or destroyed */
+	TArray<int32> PropInstances;
+
+	/** Simulated body slot of each prop, or INDEX_NONE while it's instanced */
+	TArray<int32> PropBodies;
+
+	/** Location of each instanced prop */
+	TArray<FVector> PropLocations;
+
+	/** Prop drawn by each instance */
+	TArray<int32> InstanceProps;
+
+	/** Simulated bodies, created on demand up to the budget */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UStaticMeshComponent>> Bodies;
+
+	/** Prop simulated by each body, or INDEX_NONE if the body is free */
+	TArray<int32> BodyProps;
+
+	/** Radius of a prop's bounds */
+	float PropRadius = 0.0f;
+
+	/** Center of the prop mesh's bounds, in mesh space */
+	FVector PropMeshOrigin = FVector::ZeroVector;
+
+	/** Props destroyed on the server, replicated so clients can remove them */
+	UPROPERTY(ReplicatedUsing=OnRep_DestroyedProps)
+	TArray<int32> DestroyedProps;
+
+	/** Number of destroyed props this client has already removed */
+	int32 NumDestroyedPropsApplied = 0;
+
+	/** Where each prop that was moved came to rest on the server, replicated so clients end up agreeing on prop locations */
+	UPROPERTY(ReplicatedUsing=OnRep_PropRestTransforms)
+	TArray<FCombatPropRestTransform> PropRestTransforms;
+
+	/** Blueprint damage handler for effect playback */
+	UFUNCTION(BlueprintImplementableEvent, Category="Damage")
+	void OnPropDamaged(const FVector& DamageLocation, const FVector& DamageImpulse);
+
+	/** Blueprint destruction handler for effect playback */
+	UFUNCTION(BlueprintImplementableEvent, Category="Damage")
+	void OnPropDestroyed(const FVector& PropLocation);
+
+public:
+
+	/** Initialization */
+	virtual void BeginPlay() override;
+
+	/** EndPlay cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Returns the number of props that haven't been destroyed */
+	int32 GetNumLiveProps() const;
+
+	// ~Begin CombatDamageable interface
+
+	/** Damages the prop closest to the damage location */
+	virtual void ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse) override;
+
+	/** Damages the prop registered as the item */
+	virtual void ApplyItemDamage(int32 Item, float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse) override;
+
+	/** Handles death events */
+	virtual void HandleDeath() override;
+
+	/** Handles healing events */
+	virtual void ApplyHealing(float Healing, AActor* Healer) override;
+
+	// ~End CombatDamageable interface
+
+	// ~Begin CombatEventReceiver interface
+
+	/** Plays the effects of a combat event received from the server */
+	virtual void ReceiveCombatEvent(const FCombatEvent& Event) override;
+
+	// ~End CombatEventReceiver interface
+
+	/** Registers replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+
+	/** Returns the live prop closest to the location, or INDEX_NONE if none is close enough. Used when the hit prop isn't known */
+	int32 FindPropAt(const FVector& Location) const;
+
+	/** Returns the current location of a prop */
+	FVector GetPropLocation(int32 Prop) const;
+
+	/** Moves a prop from the instanced mesh to a simulated body. Returns false if the budget is full */
+	bool PromoteProp(int32 Prop);
+
+	/** Destroys a prop, removing it from the registry and the instanced mesh */
+	void DestroyProp(int32 Prop);
+
+	/** Removes a prop's instance, fixing up the indices of the instances after it */
+	void RemovePropInstance(int32 Prop);
+
+	/** Returns a free simulated body slot, creating the body if needed, or INDEX_NONE if the budget is full */
+	int32 GetFreeBody();
+
+	/** Returns a body to the free list */
+	void ReleaseBody(int32 BodySlot);
+
+	/** Puts a live prop in the instanced mesh at the given transform, moving its instance if it already has one */
+	void PlacePropInstance(int32 Prop, const FTransform& PropTransform);
+
+	/** Returns sleeping props to the instanced mesh, and frees the bodies of destroyed ones */
+	UFUNCTION()
+	void OnBodySleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
+	/** Removes the props the server destroyed */
+	UFUNCTION()
+	void OnRep_DestroyedProps();
+
+	/** Snaps props to where they came to rest on the server */
+	UFUNCTION()
+	void OnRep_PropRestTransforms();
+};
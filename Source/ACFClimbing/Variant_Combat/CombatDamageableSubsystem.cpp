@@ -0,0 +1,384 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatDamageableSubsystem.h"
+#include "CombatDamageable.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+
+void FCombatDamageableEntry::AddHistorySample(float Time, const FVector& SampleLocation)
+{
+	// advance the head, overwriting the oldest sample once the buffer is full
+	HistoryHead = (HistoryHead + 1) % CombatHitboxHistoryLength;
+	HistoryNum = FMath::Min(HistoryNum + 1, CombatHitboxHistoryLength);
+
+	History[HistoryHead].Time = Time;
+	History[HistoryHead].Location = SampleLocation;
+}
+
+FVector FCombatDamageableEntry::GetLocationAtTime(float Time) const
+{
+	// without a history, or if the time is newer than the newest sample, use the current location
+	if (HistoryNum == 0 || Time >= History[HistoryHead].Time)
+	{
+		return Location;
+	}
+
+	// walk back from the newest sample until we bracket the time. This is bounded by the history length
+	const FCombatHitboxSample* Newer = &History[HistoryHead];
+
+	for (int32 i = 1; i < HistoryNum; ++i)
+	{
+		const FCombatHitboxSample& Older = History[(HistoryHead - i + CombatHitboxHistoryLength) % CombatHitboxHistoryLength];
+
+		if (Older.Time <= Time)
+		{
+			const float Alpha = (Time - Older.Time) / FMath::Max(Newer->Time - Older.Time, UE_KINDA_SMALL_NUMBER);
+			return FMath::Lerp(Older.Location, Newer->Location, Alpha);
+		}
+
+		Newer = &Older;
+	}
+
+	// clamp to the oldest sample
+	return Newer->Location;
+}
+
+bool FCombatDamageableEntry::TestSweep(const FVector& Start, const FVector& End, float SweepRadius, const FVector& BoundsLocation, FVector& OutImpactPoint, FVector& OutImpactNormal) const
+{
+	// find the closest points between the sweep segment and the bounds' vertical segment
+	const FVector BoundsOffset = FVector::UpVector * HalfHeight;
+	FVector SweepPoint, BoundsPoint;
+	FMath::SegmentDistToSegmentSafe(Start, End, BoundsLocation - BoundsOffset, BoundsLocation + BoundsOffset, SweepPoint, BoundsPoint);
+
+	// are the two capsules overlapping?
+	if (FVector::DistSquared(SweepPoint, BoundsPoint) > FMath::Square(SweepRadius + Radius))
+	{
+		return false;
+	}
+
+	// point the normal back towards the sweep. Fall back to the sweep direction if the segments intersect
+	OutImpactNormal = (SweepPoint - BoundsPoint).GetSafeNormal();
+	if (OutImpactNormal.IsZero())
+	{
+		OutImpactNormal = (Start - End).GetSafeNormal();
+	}
+
+	OutImpactPoint = BoundsPoint + OutImpactNormal * Radius;
+	return true;
+}
+
+void UCombatDamageableSubsystem::RegisterDamageable(AActor* Actor, ECombatTeam Team, const USceneComponent* BoundsComponent, float Radius, float HalfHeight)
+{
+	check(Actor);
+	check(BoundsComponent);
+
+	// cast once here so queries never have to
+	ICombatDamageable* Damageable = Cast<ICombatDamageable>(Actor);
+	check(Damageable);
+
+	// replace any previous registration for this actor
+	UnregisterDamageable(Actor);
+
+	FCombatDamageableEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Damageable = Damageable;
+	Entry.BoundsComponent = BoundsComponent;
+	Entry.Team = Team;
+	Entry.Radius = Radius;
+	Entry.HalfHeight = HalfHeight;
+	Entry.Location = BoundsComponent->Bounds.Origin;
+
+	// start the history at the current location so rewinds past registration don't find an empty buffer
+	if (ShouldRecordHistory())
+	{
+		Entry.AddHistorySample(GetWorld()->GetTimeSeconds(), Entry.Location);
+	}
+
+	// add the entry and index it by actor
+	EntryIndices.Add(Actor, Entries.Add(Entry));
+
+	// the new entry must be bucketed before the next query
+	bHashDirty = true;
+}
+
+void UCombatDamageableSubsystem::UnregisterDamageable(const AActor* Actor)
+{
+	int32 EntryIndex;
+	if (EntryIndices.RemoveAndCopyValue(Actor, EntryIndex))
+	{
+		Entries.RemoveAt(EntryIndex);
+
+		// drop the stale index from the hash
+		bHashDirty = true;
+	}
+
+	// remove every item the actor registered
+	if (ItemOwners.Remove(Actor) > 0)
+	{
+		for (auto It = ItemEntryIndices.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Key == Actor)
+			{
+				Entries.RemoveAt(It.Value());
+				It.RemoveCurrent();
+			}
+		}
+
+		bHashDirty = true;
+	}
+}
+
+void UCombatDamageableSubsystem::RegisterDamageableItem(AActor* Actor, int32 Item, ECombatTeam Team, const USceneComponent* BoundsComponent, const FVector& Location, float Radius)
+{
+	check(Actor);
+	check(Item != INDEX_NONE);
+
+	// replace any previous registration for this item
+	UnregisterDamageableItem(Actor, Item);
+
+	FCombatDamageableItemOwner& Owner = ItemOwners.FindOrAdd(Actor);
+
+	// cast once per owner so queries never have to
+	if (!Owner.Damageable)
+	{
+		Owner.Damageable = Cast<ICombatDamageable>(Actor);
+		check(Owner.Damageable);
+	}
+
+	Owner.Team = Team;
+	++Owner.NumItems;
+
+	FCombatDamageableEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Damageable = Owner.Damageable;
+	Entry.BoundsComponent = BoundsComponent;
+	Entry.Item = Item;
+	Entry.Team = Team;
+	Entry.Radius = Radius;
+	Entry.Location = BoundsComponent ? BoundsComponent->Bounds.Origin : Location;
+
+	// start the history at the current location so rewinds past registration don't find an empty buffer
+	if (ShouldRecordHistory())
+	{
+		Entry.AddHistorySample(GetWorld()->GetTimeSeconds(), Entry.Location);
+	}
+
+	// add the entry and index it by actor and item
+	ItemEntryIndices.Add(MakeTuple(Actor, Item), Entries.Add(Entry));
+
+	// the new entry must be bucketed before the next query
+	bHashDirty = true;
+}
+
+void UCombatDamageableSubsystem::UnregisterDamageableItem(const AActor* Actor, int32 Item)
+{
+	int32 EntryIndex;
+	if (ItemEntryIndices.RemoveAndCopyValue(MakeTuple(Actor, Item), EntryIndex))
+	{
+		Entries.RemoveAt(EntryIndex);
+
+		// forget the owner with its last item
+		FCombatDamageableItemOwner& Owner = ItemOwners.FindChecked(Actor);
+
+		if (--Owner.NumItems == 0)
+		{
+			ItemOwners.Remove(Actor);
+		}
+
+		// drop the stale index from the hash
+		bHashDirty = true;
+	}
+}
+
+ICombatDamageable* UCombatDamageableSubsystem::FindDamageable(const AActor* Actor) const
+{
+	if (const int32* EntryIndex = EntryIndices.Find(Actor))
+	{
+		return Entries[*EntryIndex].Damageable;
+	}
+
+	const FCombatDamageableItemOwner* Owner = ItemOwners.Find(Actor);
+	return Owner ? Owner->Damageable : nullptr;
+}
+
+ECombatTeam UCombatDamageableSubsystem::GetTeam(const AActor* Actor) const
+{
+	if (const int32* EntryIndex = EntryIndices.Find(Actor))
+	{
+		return Entries[*EntryIndex].Team;
+	}
+
+	const FCombatDamageableItemOwner* Owner = ItemOwners.Find(Actor);
+	return Owner ? Owner->Team : ECombatTeam::None;
+}
+
+int32 UCombatDamageableSubsystem::GetNumDamageables(ECombatTeam TeamMask) const
+{
+	int32 NumDamageables = 0;
+
+	for (const FCombatDamageableEntry& Entry : Entries)
+	{
+		if (EnumHasAnyFlags(Entry.Team, TeamMask))
+		{
+			++NumDamageables;
+		}
+	}
+
+	return NumDamageables;
+}
+
+int32 UCombatDamageableSubsystem::SweepDamageables(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, TArray<FCombatDamageableHit>& OutHits)
+{
+	return SweepDamageablesInternal(Start, End, Radius, TeamMask, IgnoredActor, -1.0f, OutHits);
+}
+
+int32 UCombatDamageableSubsystem::SweepDamageablesRewound(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, float RewindTime, TArray<FCombatDamageableHit>& OutHits)
+{
+	// clamp the rewind so the query's cell range stays bounded
+	return SweepDamageablesInternal(Start, End, Radius, TeamMask, IgnoredActor, FMath::Clamp(RewindTime, 0.0f, MaxRewindTime), OutHits);
+}
+
+void UCombatDamageableSubsystem::Tick(float DeltaTime)
+{
+	if (!ShouldRecordHistory())
+	{
+		return;
+	}
+
+	// sample at a fixed rate instead of every frame, so the history covers the same span at any frame rate
+	TimeSinceHistorySample += DeltaTime;
+
+	if (TimeSinceHistorySample < HistorySampleInterval)
+	{
+		return;
+	}
+
+	TimeSinceHistorySample = FMath::Fmod(TimeSinceHistorySample, HistorySampleInterval);
+
+	// the hash refresh also updates every entry's current location
+	UpdateSpatialHash();
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (FCombatDamageableEntry& Entry : Entries)
+	{
+		// fixed items never move, so their registration sample covers any rewind
+		if (Entry.BoundsComponent)
+		{
+			Entry.AddHistorySample(CurrentTime, Entry.Location);
+		}
+	}
+}
+
+TStatId UCombatDamageableSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatDamageableSubsystem, STATGROUP_Tickables);
+}
+
+int32 UCombatDamageableSubsystem::SweepDamageablesInternal(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, float RewindTime, TArray<FCombatDamageableHit>& OutHits)
+{
+	// make sure the hash reflects this frame's locations
+	UpdateSpatialHash();
+
+	const bool bRewind = RewindTime > 0.0f;
+	const float QueryTime = GetWorld()->GetTimeSeconds() - RewindTime;
+
+	// find the range of cells the sweep can touch, widened so entries bucketed in neighboring cells are included.
+	// Rewound entries are bucketed by their current location, so also widen by how far they could have moved since
+	const float QueryExtent = Radius + MaxEntryRadius + (bRewind ? MaxRewindSpeed * RewindTime : 0.0f);
+	const FIntPoint MinCell = GetCell(Start.ComponentMin(End) - FVector(QueryExtent));
+	const FIntPoint MaxCell = GetCell(Start.ComponentMax(End) + FVector(QueryExtent));
+
+	const int32 StartingHits = OutHits.Num();
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(CellX, CellY));
+
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const int32 EntryIndex : *Cell)
+			{
+				const FCombatDamageableEntry& Entry = Entries[EntryIndex];
+
+				// skip the attacker and anyone outside the requested teams
+				if (Entry.Actor == IgnoredActor || !EnumHasAnyFlags(Entry.Team, TeamMask))
+				{
+					continue;
+				}
+
+				// test against where the entry was at the query time. The actor itself is never moved
+				const FVector EntryLocation = bRewind ? Entry.GetLocationAtTime(QueryTime) : Entry.Location;
+
+				FVector ImpactPoint, ImpactNormal;
+				if (!Entry.TestSweep(Start, End, Radius, EntryLocation, ImpactPoint, ImpactNormal))
+				{
+					continue;
+				}
+
+				FCombatDamageableHit& Hit = OutHits.AddDefaulted_GetRef();
+				Hit.Actor = Entry.Actor;
+				Hit.Damageable = Entry.Damageable;
+				Hit.Item = Entry.Item;
+				Hit.ImpactNormal = ImpactNormal;
+				Hit.ImpactPoint = ImpactPoint;
+			}
+		}
+	}
+
+	return OutHits.Num() - StartingHits;
+}
+
+void UCombatDamageableSubsystem::UpdateSpatialHash()
+{
+	// only rebuild once per frame, unless entries were added or removed
+	if (!bHashDirty && HashFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	bHashDirty = false;
+	HashFrame = GFrameCounter;
+
+	// empty the cells but keep their allocations, damageables usually stay in the same area
+	for (TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+
+	MaxEntryRadius = 0.0f;
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FCombatDamageableEntry& Entry = *It;
+
+		// refresh the location from the bounds, which follow simulated physics. Fixed items keep theirs
+		if (Entry.BoundsComponent)
+		{
+			Entry.Location = Entry.BoundsComponent->Bounds.Origin;
+		}
+
+		// bucket the entry by its center
+		Cells.FindOrAdd(GetCell(Entry.Location)).Add(It.GetIndex());
+
+		MaxEntryRadius = FMath::Max(MaxEntryRadius, Entry.Radius);
+	}
+}
+
+bool UCombatDamageableSubsystem::ShouldRecordHistory() const
+{
+	// only servers with remote clients need to rewind
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	return NetMode == NM_DedicatedServer || NetMode == NM_ListenServer;
+}
+
+FIntPoint UCombatDamageableSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
@@ -0,0 +1,247 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatDamageableSubsystem.generated.h"
+
+class ICombatDamageable;
+class USceneComponent;
+
+/**
+ *  Team a damageable belongs to.
+ *  Values are bit flags so they can be combined into a query mask
+ */
+enum class ECombatTeam : uint8
+{
+	None		= 0,
+	Neutral		= 1 << 0,
+	Player		= 1 << 1,
+	Enemy		= 1 << 2,
+	All			= Neutral | Player | Enemy
+};
+ENUM_CLASS_FLAGS(ECombatTeam);
+
+/**
+ *  A damageable overlapped by a melee query
+ */
+struct FCombatDamageableHit
+{
+	/** Actor that was hit */
+	AActor* Actor = nullptr;
+
+	/** Cached damageable interface of the actor */
+	ICombatDamageable* Damageable = nullptr;
+
+	/** Item that was hit, or INDEX_NONE if the actor registered itself */
+	int32 Item = INDEX_NONE;
+
+	/** Point on the damageable's bounds closest to the attack */
+	FVector ImpactPoint = FVector::ZeroVector;
+
+	/** Bounds surface normal at the impact point, pointing back towards the attack */
+	FVector ImpactNormal = FVector::ZeroVector;
+};
+
+/**
+ *  Location of a damageable's bounds at a point in time, for lag compensation
+ */
+struct FCombatHitboxSample
+{
+	/** World time the sample was taken at */
+	float Time = 0.0f;
+
+	/** Bounds center at that time */
+	FVector Location = FVector::ZeroVector;
+};
+
+/** Number of hitbox history samples kept per damageable */
+static constexpr int32 CombatHitboxHistoryLength = 16;
+
+/**
+ *  A damageable registered with the subsystem.
+ *  Bounds are a vertical capsule around the bounds component's center; zero half height makes it a sphere
+ */
+struct FCombatDamageableEntry
+{
+	/** Registered actor. Owners unregister on EndPlay, so this never dangles */
+	AActor* Actor = nullptr;
+
+	/** Interface pointer cast once at registration */
+	ICombatDamageable* Damageable = nullptr;
+
+	/** Component whose bounds origin is tracked. Null for items at a fixed location */
+	const USceneComponent* BoundsComponent = nullptr;
+
+	/** Item index for actors that register many damageables, or INDEX_NONE for a whole actor */
+	int32 Item = INDEX_NONE;
+
+	/** Team used to filter queries */
+	ECombatTeam Team = ECombatTeam::Neutral;
+
+	/** Radius of the bounds */
+	float Radius = 0.0f;
+
+	/** Half height of the bounds' vertical segment, not counting the radius */
+	float HalfHeight = 0.0f;
+
+	/** Bounds center, refreshed when the spatial hash is rebuilt */
+	FVector Location = FVector::ZeroVector;
+
+	/** Ring buffer of recent bounds centers. Only recorded on network servers */
+	TStaticArray<FCombatHitboxSample, CombatHitboxHistoryLength> History;
+
+	/** Index of the newest history sample */
+	int32 HistoryHead = INDEX_NONE;
+
+	/** Number of valid history samples */
+	int32 HistoryNum = 0;
+
+	/** Adds a sample to the history, overwriting the oldest one when full */
+	void AddHistorySample(float Time, const FVector& SampleLocation);
+
+	/** Returns the bounds center at the given time, interpolated from the history and clamped to the oldest sample */
+	FVector GetLocationAtTime(float Time) const;
+
+	/**
+	 *  Tests a sphere swept from Start to End against the bounds centered at BoundsLocation.
+	 *  On overlap, returns true along with the impact point on the bounds and the normal pointing back towards the sweep
+	 */
+	bool TestSweep(const FVector& Start, const FVector& End, float SweepRadius, const FVector& BoundsLocation, FVector& OutImpactPoint, FVector& OutImpactNormal) const;
+};
+
+/**
+ *  An actor that registered damageable items instead of itself
+ */
+struct FCombatDamageableItemOwner
+{
+	/** Interface pointer cast once at registration */
+	ICombatDamageable* Damageable = nullptr;
+
+	/** Team of the items */
+	ECombatTeam Team = ECombatTeam::Neutral;
+
+	/** Number of registered items */
+	int32 NumItems = 0;
+};
+
+/**
+ *  Registry of every ICombatDamageable in the world.
+ *  Damageables are stored in a uniform 2D spatial hash so melee attacks can find their targets
+ *  without going through the physics scene or casting and checking tags on every hit.
+ *  On network servers, a short history of every damageable's location is also kept,
+ *  so remote players' attacks can be tested against where targets were on their screen
+ */
+UCLASS()
+class UCombatDamageableSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Size of a spatial hash cell */
+	float CellSize = 400.0f;
+
+	/** Registered damageables */
+	TSparseArray<FCombatDamageableEntry> Entries;
+
+	/** Maps each registered actor to its entry index */
+	TMap<const AActor*, int32> EntryIndices;
+
+	/** Maps each registered item to its entry index */
+	TMap<TPair<const AActor*, int32>, int32> ItemEntryIndices;
+
+	/** Actors with registered items */
+	TMap<const AActor*, FCombatDamageableItemOwner> ItemOwners;
+
+	/** Entry indices bucketed by the cell their center falls in */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** Largest registered radius, used to widen queries into neighboring cells */
+	float MaxEntryRadius = 0.0f;
+
+	/** Frame the spatial hash was last rebuilt on */
+	uint64 HashFrame = 0;
+
+	/** If true, the spatial hash must be rebuilt before the next query */
+	bool bHashDirty = true;
+
+	/** Time between hitbox history samples, roughly the server's net tick */
+	float HistorySampleInterval = 1.0f / 30.0f;
+
+	/** Rewinds further back than this are clamped. Must be covered by the history length */
+	float MaxRewindTime = 0.4f;
+
+	/** Fastest expected damageable speed, used to widen rewound queries into cells targets may have left since */
+	float MaxRewindSpeed = 1500.0f;
+
+	/** Time accumulated since the last history sample */
+	float TimeSinceHistorySample = 0.0f;
+
+public:
+
+	/** Registers a damageable actor. BoundsComponent must be owned by the actor */
+	void RegisterDamageable(AActor* Actor, ECombatTeam Team, const USceneComponent* BoundsComponent, float Radius, float HalfHeight = 0.0f);
+
+	/** Removes a damageable actor, and any items it registered, so it can no longer be hit */
+	void UnregisterDamageable(const AActor* Actor);
+
+	/**
+	 *  Registers one of many damageables owned by an actor, e.g. a prop in an instanced field. Hits report the owning actor,
+	 *  which resolves the item from the impact point. Bounds follow BoundsComponent if set, otherwise they stay at Location
+	 */
+	void RegisterDamageableItem(AActor* Actor, int32 Item, ECombatTeam Team, const USceneComponent* BoundsComponent, const FVector& Location, float Radius);
+
+	/** Removes a single damageable item */
+	void UnregisterDamageableItem(const AActor* Actor, int32 Item);
+
+	/** Returns the damageable interface of a registered actor, or nullptr if not registered */
+	ICombatDamageable* FindDamageable(const AActor* Actor) const;
+
+	/** Returns the team of a registered actor, or None if not registered */
+	ECombatTeam GetTeam(const AActor* Actor) const;
+
+	/** Returns the number of registered damageables in the given teams */
+	int32 GetNumDamageables(ECombatTeam TeamMask) const;
+
+	/**
+	 *  Finds every registered damageable in the given teams touched by a sphere swept from Start to End.
+	 *  Returns the number of hits added to OutHits
+	 */
+	int32 SweepDamageables(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, TArray<FCombatDamageableHit>& OutHits);
+
+	/**
+	 *  Same as SweepDamageables, but tests against where damageables were RewindTime seconds ago according to the hitbox history.
+	 *  Rewinds are clamped to the history length. Actors are never moved
+	 */
+	int32 SweepDamageablesRewound(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, float RewindTime, TArray<FCombatDamageableHit>& OutHits);
+
+	/** Returns the longest supported rewind */
+	float GetMaxRewindTime() const { return MaxRewindTime; }
+
+	// ~begin FTickableGameObject interface
+
+	/** Samples the hitbox history of moving damageables on network servers */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+
+protected:
+
+	/** Shared query for current and rewound sweeps. A negative rewind time tests current locations */
+	int32 SweepDamageablesInternal(const FVector& Start, const FVector& End, float Radius, ECombatTeam TeamMask, const AActor* IgnoredActor, float RewindTime, TArray<FCombatDamageableHit>& OutHits);
+
+	/** Returns true if this world needs a hitbox history */
+	bool ShouldRecordHistory() const;
+
+	/** Refreshes entry locations and re-buckets them, at most once per frame */
+	void UpdateSpatialHash();
+
+	/** Returns the spatial hash cell for a location */
+	FIntPoint GetCell(const FVector& Location) const;
+};
@@ -5,6 +5,7 @@
 #include "Components/SceneComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
+#include "CombatDamageableSubsystem.h"
 
 ACombatDummy::ACombatDummy()
 {
@@ -31,6 +32,25 @@ ACombatDummy::ACombatDummy()
 	PhysicsConstraint->SetConstrainedComponents(BasePlate, NAME_None, Dummy, NAME_None);
 }
 
+void ACombatDummy::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// register the physics dummy as a damageable so melee attacks can find it
+	GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->RegisterDamageable(this, ECombatTeam::Neutral, Dummy, Dummy->Bounds.SphereRadius);
+}
+
+void ACombatDummy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// unregister from the damageable registry. The subsystem may already be gone during world teardown
+	if (UCombatDamageableSubsystem* DamageableSubsystem = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>())
+	{
+		DamageableSubsystem->UnregisterDamageable(this);
+	}
+}
+
 void ACombatDummy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
 {
 	// apply impulse to the dummy
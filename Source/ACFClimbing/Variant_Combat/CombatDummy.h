@@ -54,6 +54,12 @@ public:
 
 protected:
 
+	/** Initialization */
+	virtual void BeginPlay() override;
+
+	/** Cleanup */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Blueprint handle to apply damage effects */
 	UFUNCTION(BlueprintImplementableEvent, Category="Combat", meta=(DisplayName = "On Dummy Damaged"))
 	void BP_OnDummyDamaged(const FVector& Location, const FVector& Direction);
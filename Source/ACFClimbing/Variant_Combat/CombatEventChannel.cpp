@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatEventChannel.h"
+#include "Components/SceneComponent.h"
+
+bool FCombatEventBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumEvents = Events.Num();
+	Ar.SerializeIntPacked(NumEvents);
+
+	if (Ar.IsLoading())
+	{
+		// reject malformed batches before allocating for them
+		if (NumEvents > MaxEvents)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+
+		Events.SetNum(NumEvents);
+	}
+
+	for (FCombatEvent& Event : Events)
+	{
+		bOutSuccess &= Event.NetSerialize(Ar, Map);
+	}
+
+	return true;
+}
+
+ACombatEventChannel::ACombatEventChannel()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	// give the channel a location so it can be spatialized. It never moves
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	RootComponent->SetMobility(EComponentMobility::Static);
+
+	// replicate only to connections near the cell
+	bReplicates = true;
+	bAlwaysRelevant = false;
+	SetReplicatingMovement(false);
+	SetNetCullDistanceSquared(FMath::Square(15000.0f));
+}
+
+bool ACombatEventChannel::AddEvent(const FCombatEvent& Event)
+{
+	PendingEvents.Events.Add(Event);
+
+	return PendingEvents.Events.Num() >= FCombatEventBatch::MaxEvents;
+}
+
+int32 ACombatEventChannel::FlushEvents()
+{
+	int32 Bits = 0;
+
+	for (const FCombatEvent& Event : PendingEvents.Events)
+	{
+		Bits += Event.GetApproximateNetBits();
+	}
+
+	// one unreliable multicast for the whole batch
+	MulticastCombatEvents(PendingEvents);
+
+	// keep the allocation for the next batch
+	PendingEvents.Events.Reset();
+
+	return Bits;
+}
+
+void ACombatEventChannel::MulticastCombatEvents_Implementation(const FCombatEventBatch& Batch)
+{
+	// the server already played these events when they happened
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	for (const FCombatEvent& Event : Batch.Events)
+	{
+		// skip events for actors that aren't relevant to this client
+		if (ICombatEventReceiver* Receiver = Cast<ICombatEventReceiver>(Event.Actor))
+		{
+			Receiver->ReceiveCombatEvent(Event);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "CombatEventReceiver.h"
+#include "CombatEventChannel.generated.h"
+
+/**
+ *  A batch of combat events sent in a single RPC
+ */
+USTRUCT()
+struct FCombatEventBatch
+{
+	GENERATED_BODY()
+
+	/** Largest batch a client will accept */
+	static constexpr int32 MaxEvents = 64;
+
+	/** Events in the order they happened on the server */
+	UPROPERTY()
+	TArray<FCombatEvent> Events;
+
+	/** Bit-packs the event count followed by each event */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatEventBatch> : public TStructOpsTypeTraitsBase2<FCombatEventBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ *  Replicated actor that carries the combat events of one relevancy cell.
+ *  Placed at the center of its cell so only connections close enough to see the events receive them
+ */
+UCLASS(NotPlaceable, Transient)
+class ACombatEventChannel : public AInfo
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Events waiting for the next flush */
+	FCombatEventBatch PendingEvents;
+
+public:
+
+	/** Constructor */
+	ACombatEventChannel();
+
+	/** Adds an event to the next batch. Returns true if the batch is full and should be flushed right away */
+	bool AddEvent(const FCombatEvent& Event);
+
+	/** Returns the number of events waiting to be sent */
+	int32 GetNumPendingEvents() const { return PendingEvents.Events.Num(); }
+
+	/** Sends the pending events to relevant clients. Returns the approximate number of bits sent */
+	int32 FlushEvents();
+
+protected:
+
+	/** Plays the batched events on clients */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastCombatEvents(const FCombatEventBatch& Batch);
+};
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatEventReceiver.h"
+#include "Engine/NetSerialization.h"
+#include "GameFramework/Actor.h"
+
+namespace CombatEventBits
+{
+	/** Bits used by each part of a packed event */
+	constexpr int32 Type = 2;
+	constexpr int32 ObjectReference = 32;
+	constexpr int32 AttackMontage = 1;
+	constexpr int32 AttackSection = FCombatEvent::AttackSectionBits;
+	constexpr int32 Location = 3 * 20;
+	constexpr int32 Direction = 3 * 8;
+	constexpr int32 Damage = 16;
+}
+
+namespace
+{
+	/** Packs a damage amount in tenths of a point */
+	void SerializeDamage(FArchive& Ar, float& Damage)
+	{
+		uint16 PackedDamage = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt32(Damage * 10.0f), 0, int32(MAX_uint16)));
+		Ar << PackedDamage;
+		Damage = PackedDamage * 0.1f;
+	}
+}
+
+bool FCombatEvent::NetSerialize(FArchive& Ar, UPackageMap* Map)
+{
+	bool bSuccess = true;
+
+	// the type decides which fields follow
+	uint32 PackedType = static_cast<uint32>(Type);
+	Ar.SerializeInt(PackedType, static_cast<uint32>(ECombatEventType::Count));
+	Type = static_cast<ECombatEventType>(PackedType);
+
+	UObject* ActorObject = Actor;
+	bSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), ActorObject);
+	Actor = Cast<AActor>(ActorObject);
+
+	switch (Type)
+	{
+	case ECombatEventType::AttackStart:
+	case ECombatEventType::AttackSection:
+
+		Ar.SerializeBits(&AttackMontage, CombatEventBits::AttackMontage);
+		Ar.SerializeBits(&AttackSection, CombatEventBits::AttackSection);
+		break;
+
+	case ECombatEventType::Hit:
+	{
+		UObject* TargetObject = Target;
+		bSuccess &= Map->SerializeObject(Ar, AActor::StaticClass(), TargetObject);
+		Target = Cast<AActor>(TargetObject);
+
+		bSuccess &= SerializePackedVector<1, 20>(Location, Ar);
+		SerializeDamage(Ar, Damage);
+		break;
+	}
+
+	case ECombatEventType::Damage:
+
+		bSuccess &= SerializePackedVector<1, 20>(Location, Ar);
+		bSuccess &= SerializeFixedVector<1, 8>(Direction, Ar);
+		SerializeDamage(Ar, Damage);
+		break;
+
+	default:
+		break;
+	}
+
+	return bSuccess;
+}
+
+int32 FCombatEvent::GetApproximateNetBits() const
+{
+	int32 Bits = CombatEventBits::Type + CombatEventBits::ObjectReference;
+
+	switch (Type)
+	{
+	case ECombatEventType::AttackStart:
+	case ECombatEventType::AttackSection:
+		Bits += CombatEventBits::AttackMontage + CombatEventBits::AttackSection;
+		break;
+
+	case ECombatEventType::Hit:
+		Bits += CombatEventBits::ObjectReference + CombatEventBits::Location + CombatEventBits::Damage;
+		break;
+
+	case ECombatEventType::Damage:
+		Bits += CombatEventBits::Location + CombatEventBits::Direction + CombatEventBits::Damage;
+		break;
+
+	default:
+		break;
+	}
+
+	return Bits;
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "CombatEventReceiver.generated.h"
+
+/**
+ *  Type of a replicated combat event
+ */
+UENUM()
+enum class ECombatEventType : uint8
+{
+	AttackStart,
+	AttackSection,
+	Hit,
+	Damage,
+	Count UMETA(Hidden)
+};
+
+/**
+ *  A combat event sent from the server to clients so they can play its effects.
+ *  Only the fields used by the event's type are sent
+ */
+USTRUCT()
+struct FCombatEvent
+{
+	GENERATED_BODY()
+
+	/** Type of the event */
+	UPROPERTY()
+	ECombatEventType Type = ECombatEventType::AttackStart;
+
+	/** Actor the event happened to. Attacker for attack and hit events */
+	UPROPERTY()
+	TObjectPtr<AActor> Actor;
+
+	/** Actor that was hit, for hit events */
+	UPROPERTY()
+	TObjectPtr<AActor> Target;
+
+	/** Attack montage slot on the actor, for attack events. 0 is the combo attack, 1 the charged attack */
+	UPROPERTY()
+	uint8 AttackMontage = 0;
+
+	/** Montage section index, for attack section events. Must fit in AttackSectionBits */
+	UPROPERTY()
+	uint8 AttackSection = 0;
+
+	/** Bits used to send the section index */
+	static constexpr int32 AttackSectionBits = 5;
+
+	/** Impact point for hit and damage events. Quantized to 1cm */
+	UPROPERTY()
+	FVector Location = FVector::ZeroVector;
+
+	/** Damage direction, for damage events. Quantized to 8 bits per axis */
+	UPROPERTY()
+	FVector Direction = FVector::ZeroVector;
+
+	/** Damage amount, for hit and damage events. Quantized to 0.1 */
+	UPROPERTY()
+	float Damage = 0.0f;
+
+	/** Bit-packs the event */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map);
+
+	/** Returns the approximate packed size of the event, for bandwidth reports */
+	int32 GetApproximateNetBits() const;
+};
+
+/**
+ *  CombatEventReceiver interface
+ *  Plays the client-side effects of replicated combat events
+ */
+UINTERFACE(MinimalAPI, NotBlueprintable)
+class UCombatEventReceiver : public UInterface
+{
+	GENERATED_BODY()
+};
+
+class ICombatEventReceiver
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Plays the effects of a combat event received from the server */
+	virtual void ReceiveCombatEvent(const FCombatEvent& Event) = 0;
+};
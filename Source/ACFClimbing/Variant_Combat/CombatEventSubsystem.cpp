@@ -0,0 +1,183 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatEventSubsystem.h"
+#include "CombatEventChannel.h"
+#include "CombatDamageableSubsystem.h"
+#include "Engine/World.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCombatEvents, Log, All);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events Sent"), STAT_CombatEventsSent, STATGROUP_CombatEvents);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Event Batches Sent"), STAT_CombatEventBatchesSent, STATGROUP_CombatEvents);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Approximate Event Bits Sent"), STAT_CombatEventBitsSent, STATGROUP_CombatEvents);
+
+void UCombatEventSubsystem::PostAttackStart(AActor* Attacker, uint8 AttackMontage)
+{
+	FCombatEvent Event;
+	Event.Type = ECombatEventType::AttackStart;
+	Event.Actor = Attacker;
+	Event.AttackMontage = AttackMontage;
+
+	PostEvent(Event);
+}
+
+void UCombatEventSubsystem::PostAttackSection(AActor* Attacker, uint8 AttackMontage, int32 SectionIndex)
+{
+	// sections that don't exist can't be sent
+	if (SectionIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// sections that don't fit the packed index would arrive truncated and jump to the wrong section
+	if (!ensureMsgf(SectionIndex < (1 << FCombatEvent::AttackSectionBits), TEXT("Attack section %d doesn't fit in %d bits"), SectionIndex, FCombatEvent::AttackSectionBits))
+	{
+		return;
+	}
+
+	FCombatEvent Event;
+	Event.Type = ECombatEventType::AttackSection;
+	Event.Actor = Attacker;
+	Event.AttackMontage = AttackMontage;
+	Event.AttackSection = static_cast<uint8>(SectionIndex);
+
+	PostEvent(Event);
+}
+
+void UCombatEventSubsystem::PostHit(AActor* Attacker, AActor* Target, float Damage, const FVector& ImpactPoint)
+{
+	FCombatEvent Event;
+	Event.Type = ECombatEventType::Hit;
+	Event.Actor = Attacker;
+	Event.Target = Target;
+	Event.Damage = Damage;
+	Event.Location = ImpactPoint;
+
+	PostEvent(Event);
+}
+
+void UCombatEventSubsystem::PostDamage(AActor* Damaged, float Damage, const FVector& DamageLocation, const FVector& DamageDirection)
+{
+	FCombatEvent Event;
+	Event.Type = ECombatEventType::Damage;
+	Event.Actor = Damaged;
+	Event.Damage = Damage;
+	Event.Location = DamageLocation;
+	Event.Direction = DamageDirection;
+
+	PostEvent(Event);
+}
+
+void UCombatEventSubsystem::Tick(float DeltaTime)
+{
+	if (!ShouldSendEvents())
+	{
+		return;
+	}
+
+	// batch all events posted since the last net update
+	TimeSinceFlush += DeltaTime;
+
+	if (TimeSinceFlush >= FlushInterval)
+	{
+		TimeSinceFlush = FMath::Fmod(TimeSinceFlush, FlushInterval);
+
+		for (const TPair<FIntPoint, TObjectPtr<ACombatEventChannel>>& Channel : Channels)
+		{
+			if (Channel.Value && Channel.Value->GetNumPendingEvents() > 0)
+			{
+				FlushChannel(Channel.Value);
+			}
+		}
+	}
+
+	// periodically report the bandwidth
+	TimeSinceReport += DeltaTime;
+
+	if (TimeSinceReport >= ReportInterval)
+	{
+		ReportBandwidth();
+	}
+}
+
+TStatId UCombatEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatEventSubsystem, STATGROUP_Tickables);
+}
+
+bool UCombatEventSubsystem::ShouldSendEvents() const
+{
+	// only servers with remote clients need to send events
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	return NetMode == NM_DedicatedServer || NetMode == NM_ListenServer;
+}
+
+void UCombatEventSubsystem::PostEvent(const FCombatEvent& Event)
+{
+	if (!ShouldSendEvents() || !Event.Actor)
+	{
+		return;
+	}
+
+	// send the event to the clients near the actor. Flush early if the batch is full
+	if (ACombatEventChannel* Channel = GetChannel(Event.Actor->GetActorLocation()))
+	{
+		if (Channel->AddEvent(Event))
+		{
+			FlushChannel(Channel);
+		}
+	}
+}
+
+ACombatEventChannel* UCombatEventSubsystem::GetChannel(const FVector& Location)
+{
+	const FIntPoint Cell(FMath::FloorToInt32(Location.X / ChannelCellSize), FMath::FloorToInt32(Location.Y / ChannelCellSize));
+
+	TObjectPtr<ACombatEventChannel>& Channel = Channels.FindOrAdd(Cell);
+
+	if (!Channel)
+	{
+		// spawn the channel at the center of its cell
+		const FVector CellCenter((Cell.X + 0.5f) * ChannelCellSize, (Cell.Y + 0.5f) * ChannelCellSize, 0.0f);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Channel = GetWorld()->SpawnActor<ACombatEventChannel>(CellCenter, FRotator::ZeroRotator, SpawnParams);
+	}
+
+	return Channel;
+}
+
+void UCombatEventSubsystem::FlushChannel(ACombatEventChannel* Channel)
+{
+	const int32 NumEvents = Channel->GetNumPendingEvents();
+	const int32 Bits = Channel->FlushEvents();
+
+	INC_DWORD_STAT_BY(STAT_CombatEventsSent, NumEvents);
+	INC_DWORD_STAT(STAT_CombatEventBatchesSent);
+	INC_DWORD_STAT_BY(STAT_CombatEventBitsSent, Bits);
+
+	ReportEvents += NumEvents;
+	ReportBits += Bits;
+	++ReportBatches;
+}
+
+void UCombatEventSubsystem::ReportBandwidth()
+{
+	const int32 NumEnemies = GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->GetNumDamageables(ECombatTeam::Enemy);
+
+	// bandwidth per relevant client, since every batch goes to each connection in its cell
+	UE_LOG(LogCombatEvents, Verbose, TEXT("%d enemies: %.1f bytes/s, %d events/s in %d batches/s across %d channels"),
+		NumEnemies,
+		ReportBits / (8.0f * TimeSinceReport),
+		FMath::RoundToInt32(ReportEvents / TimeSinceReport),
+		FMath::RoundToInt32(ReportBatches / TimeSinceReport),
+		Channels.Num());
+
+	TimeSinceReport = 0.0f;
+	ReportEvents = 0;
+	ReportBits = 0;
+	ReportBatches = 0;
+}
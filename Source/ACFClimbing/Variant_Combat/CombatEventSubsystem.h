@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatEventReceiver.h"
+#include "CombatEventSubsystem.generated.h"
+
+class ACombatEventChannel;
+
+DECLARE_STATS_GROUP(TEXT("CombatEvents"), STATGROUP_CombatEvents, STATCAT_Advanced);
+
+/**
+ *  Sends combat events from the server to clients.
+ *  Events are bucketed by the relevancy cell they happen in, and each cell's events are sent
+ *  in a single batched unreliable multicast per net update. Persistent state like HP replicates separately.
+ *  Posting events does nothing on clients and in standalone games
+ */
+UCLASS()
+class UCombatEventSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Size of a relevancy cell */
+	float ChannelCellSize = 5000.0f;
+
+	/** Time between flushes, roughly the server's net update rate */
+	float FlushInterval = 1.0f / 30.0f;
+
+	/** Time between bandwidth reports in the log */
+	float ReportInterval = 1.0f;
+
+	/** Event channels by relevancy cell, spawned on demand */
+	UPROPERTY(Transient)
+	TMap<FIntPoint, TObjectPtr<ACombatEventChannel>> Channels;
+
+	/** Time accumulated since the last flush */
+	float TimeSinceFlush = 0.0f;
+
+	/** Time accumulated since the last bandwidth report */
+	float TimeSinceReport = 0.0f;
+
+	/** Events sent since the last bandwidth report */
+	int32 ReportEvents = 0;
+
+	/** Batches sent since the last bandwidth report */
+	int32 ReportBatches = 0;
+
+	/** Approximate bits sent since the last bandwidth report */
+	int32 ReportBits = 0;
+
+public:
+
+	/** Posts the start of an attack montage */
+	void PostAttackStart(AActor* Attacker, uint8 AttackMontage);
+
+	/** Posts an attack montage jumping to a new section */
+	void PostAttackSection(AActor* Attacker, uint8 AttackMontage, int32 SectionIndex);
+
+	/** Posts an attacker hitting a target */
+	void PostHit(AActor* Attacker, AActor* Target, float Damage, const FVector& ImpactPoint);
+
+	/** Posts a damageable receiving damage */
+	void PostDamage(AActor* Damaged, float Damage, const FVector& DamageLocation, const FVector& DamageDirection);
+
+	// ~begin FTickableGameObject interface
+
+	/** Flushes the pending events and reports bandwidth */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+
+protected:
+
+	/** Returns true if this world has clients to send events to */
+	bool ShouldSendEvents() const;
+
+	/** Adds the event to the channel of the cell its actor is in */
+	void PostEvent(const FCombatEvent& Event);
+
+	/** Returns the channel for the cell containing the location, spawning it if needed */
+	ACombatEventChannel* GetChannel(const FVector& Location);
+
+	/** Sends a channel's pending events and updates the stats */
+	void FlushChannel(ACombatEventChannel* Channel);
+
+	/** Logs the event bandwidth against the number of registered enemies */
+	void ReportBandwidth();
+};
@@ -2,8 +2,10 @@
 
 
 #include "Variant_Combat/CombatGameMode.h"
+#include "CombatHUD.h"
 
 ACombatGameMode::ACombatGameMode()
 {
-
+	// use the HUD that draws all life bars in one pass
+	HUDClass = ACombatHUD::StaticClass();
 }
\ No newline at end of file
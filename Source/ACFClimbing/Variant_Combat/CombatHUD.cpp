@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatHUD.h"
+#include "CombatLifeBarSubsystem.h"
+#include "Engine/Canvas.h"
+#include "SceneView.h"
+
+void ACombatHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	DrawLifeBars();
+}
+
+void ACombatHUD::DrawLifeBars()
+{
+	const UCombatLifeBarSubsystem* LifeBarSubsystem = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>();
+
+	// we need a view to project the bars
+	if (!LifeBarSubsystem || !Canvas || !Canvas->SceneView)
+	{
+		return;
+	}
+
+	// get the camera location once for distance culling
+	const FVector ViewOrigin = Canvas->SceneView->ViewMatrices.GetViewOrigin();
+	const float MaxDistanceSquared = FMath::Square(LifeBarDrawDistance);
+
+	const FVector2D HalfSize = LifeBarSize * 0.5f;
+
+	for (const FCombatLifeBarEntry& LifeBar : LifeBarSubsystem->GetLifeBars())
+	{
+		// skip hidden bars and actors
+		if (!LifeBar.bVisible || LifeBar.Actor->IsHidden())
+		{
+			continue;
+		}
+
+		// find the bar's world location
+		const FVector WorldLocation = LifeBar.Actor->GetActorLocation() + LifeBar.Actor->GetActorQuat().RotateVector(LifeBar.Offset);
+
+		// cull distant bars before paying for the projection
+		if (FVector::DistSquared(WorldLocation, ViewOrigin) > MaxDistanceSquared)
+		{
+			continue;
+		}
+
+		// project to the screen. Depth is clamped to zero for bars behind the camera
+		const FVector ScreenLocation = Canvas->Project(WorldLocation, true);
+
+		if (ScreenLocation.Z <= 0.0f)
+		{
+			continue;
+		}
+
+		// cull bars that are fully off screen
+		if (ScreenLocation.X + HalfSize.X < 0.0f || ScreenLocation.X - HalfSize.X > Canvas->ClipX
+			|| ScreenLocation.Y + HalfSize.Y < 0.0f || ScreenLocation.Y - HalfSize.Y > Canvas->ClipY)
+		{
+			continue;
+		}
+
+		const float Left = ScreenLocation.X - HalfSize.X;
+		const float Top = ScreenLocation.Y - HalfSize.Y;
+
+		// draw the background and the fill. Both use the default white texture so the canvas batches them together
+		DrawRect(LifeBarBackgroundColor, Left, Top, LifeBarSize.X, LifeBarSize.Y);
+		DrawRect(LifeBar.Color, Left, Top, LifeBarSize.X * LifeBar.Percent, LifeBarSize.Y);
+	}
+}
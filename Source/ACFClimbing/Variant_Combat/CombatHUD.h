@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "CombatHUD.generated.h"
+
+/**
+ *  Simple HUD for a third person combat game
+ *  Draws the life bars of every combat actor in view in a single canvas pass
+ */
+UCLASS()
+class ACombatHUD : public AHUD
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Screen size of each life bar */
+	UPROPERTY(EditAnywhere, Category="Life Bars")
+	FVector2D LifeBarSize = FVector2D(80.0f, 8.0f);
+
+	/** Color drawn behind the life bar fill */
+	UPROPERTY(EditAnywhere, Category="Life Bars")
+	FLinearColor LifeBarBackgroundColor = FLinearColor(0.0f, 0.0f, 0.0f, 0.5f);
+
+	/** Life bars further than this from the camera are not drawn */
+	UPROPERTY(EditAnywhere, Category="Life Bars", meta = (ClampMin = 0, Units = "cm"))
+	float LifeBarDrawDistance = 3000.0f;
+
+public:
+
+	/** Draws the HUD */
+	virtual void DrawHUD() override;
+
+protected:
+
+	/** Projects, culls and draws every registered life bar */
+	void DrawLifeBars();
+};
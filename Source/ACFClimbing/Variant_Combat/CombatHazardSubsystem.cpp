@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatHazardSubsystem.h"
+#include "CombatDamageQueueSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Hazards"), STAT_CombatUpdateHazards, STATGROUP_CombatHazards);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hazard Occupants"), STAT_CombatHazardOccupants, STATGROUP_CombatHazards);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hazard Damage Ticks"), STAT_CombatHazardDamageTicks, STATGROUP_CombatHazards);
+
+void UCombatHazardSubsystem::AddOccupant(AActor* Hazard, AActor* Occupant, float Damage, float Interval)
+{
+	check(Hazard && Occupant);
+
+	// ignore actors that are already inside this hazard
+	const bool bAlreadyInside = Occupants.ContainsByPredicate([Hazard, Occupant](const FCombatHazardOccupant& Entry)
+	{
+		return Entry.Hazard == Hazard && Entry.Occupant == Occupant;
+	});
+
+	if (bAlreadyInside)
+	{
+		return;
+	}
+
+	FCombatHazardOccupant& Entry = Occupants.AddDefaulted_GetRef();
+	Entry.Hazard = Hazard;
+	Entry.Occupant = Occupant;
+	Entry.Damage = Damage;
+	Entry.Interval = FMath::Max(Interval, UE_KINDA_SMALL_NUMBER);
+	Entry.TimeUntilDamage = 0.0f;
+}
+
+void UCombatHazardSubsystem::RemoveOccupant(const AActor* Hazard, const AActor* Occupant)
+{
+	Occupants.RemoveAllSwap([Hazard, Occupant](const FCombatHazardOccupant& Entry)
+	{
+		return Entry.Hazard == Hazard && Entry.Occupant == Occupant;
+	});
+}
+
+void UCombatHazardSubsystem::RemoveHazard(const AActor* Hazard)
+{
+	Occupants.RemoveAllSwap([Hazard](const FCombatHazardOccupant& Entry)
+	{
+		return Entry.Hazard == Hazard;
+	});
+}
+
+void UCombatHazardSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CombatUpdateHazards);
+
+	INC_DWORD_STAT_BY(STAT_CombatHazardOccupants, Occupants.Num());
+
+	if (Occupants.IsEmpty())
+	{
+		return;
+	}
+
+	UCombatDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UCombatDamageQueueSubsystem>();
+
+	for (int32 i = Occupants.Num() - 1; i >= 0; --i)
+	{
+		FCombatHazardOccupant& Entry = Occupants[i];
+
+		// drop occupants whose hazard or actor was destroyed
+		AActor* Hazard = Entry.Hazard.Get();
+		AActor* Occupant = Entry.Occupant.Get();
+
+		if (!Hazard || !Occupant)
+		{
+			Occupants.RemoveAtSwap(i, EAllowShrinking::No);
+			continue;
+		}
+
+		Entry.TimeUntilDamage -= DeltaTime;
+
+		if (Entry.TimeUntilDamage > 0.0f)
+		{
+			continue;
+		}
+
+		// catch up on every interval that elapsed this frame, so long frames deal the same damage as short ones
+		int32 NumTicks = 0;
+
+		while (Entry.TimeUntilDamage <= 0.0f)
+		{
+			Entry.TimeUntilDamage += Entry.Interval;
+			++NumTicks;
+		}
+
+		DamageQueue->QueueDamage(Occupant, Entry.Damage * NumTicks, Hazard, Occupant->GetActorLocation(), FVector::ZeroVector);
+
+		INC_DWORD_STAT_BY(STAT_CombatHazardDamageTicks, NumTicks);
+	}
+}
+
+TStatId UCombatHazardSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatHazardSubsystem, STATGROUP_Tickables);
+}
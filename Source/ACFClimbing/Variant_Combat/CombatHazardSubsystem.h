@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatHazardSubsystem.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("CombatHazards"), STATGROUP_CombatHazards, STATCAT_Advanced);
+
+/**
+ *  An actor standing inside a damage over time hazard
+ */
+struct FCombatHazardOccupant
+{
+	/** Hazard dealing the damage */
+	TWeakObjectPtr<AActor> Hazard;
+
+	/** Actor inside the hazard */
+	TWeakObjectPtr<AActor> Occupant;
+
+	/** Damage dealt every interval */
+	float Damage = 0.0f;
+
+	/** Time between damage ticks */
+	float Interval = 0.0f;
+
+	/** Time left until the next damage tick */
+	float TimeUntilDamage = 0.0f;
+};
+
+/**
+ *  Applies damage over time from every hazard in the world in one batched pass.
+ *  Hazards report actors entering and leaving them, and each occupant is damaged on a fixed interval,
+ *  so the cost scales with the number of occupants instead of the number of contacts, and doesn't depend on the frame rate.
+ *  Damage goes through the damage queue, so it's resolved with the rest of the frame's combat damage
+ */
+UCLASS()
+class UCombatHazardSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Actors currently inside a hazard. One entry per hazard and occupant pair */
+	TArray<FCombatHazardOccupant> Occupants;
+
+public:
+
+	/** Starts damaging the actor on an interval. The first damage tick lands on the next update */
+	void AddOccupant(AActor* Hazard, AActor* Occupant, float Damage, float Interval);
+
+	/** Stops damaging the actor */
+	void RemoveOccupant(const AActor* Hazard, const AActor* Occupant);
+
+	/** Stops damaging every occupant of the hazard */
+	void RemoveHazard(const AActor* Hazard);
+
+	/** Returns the number of actors inside hazards */
+	int32 GetNumOccupants() const { return Occupants.Num(); }
+
+	// ~begin FTickableGameObject interface
+
+	/** Counts down the occupants' damage intervals and queues their damage */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+};
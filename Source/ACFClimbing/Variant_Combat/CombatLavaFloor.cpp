@@ -2,8 +2,12 @@
 
 
 #include "CombatLavaFloor.h"
-#include "CombatDamageable.h"
+#include "CombatDamageableSubsystem.h"
+#include "CombatHazardSubsystem.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/BoxComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
 
 ACombatLavaFloor::ACombatLavaFloor()
 {
@@ -12,16 +16,89 @@ ACombatLavaFloor::ACombatLavaFloor()
 	// create the mesh
 	RootComponent = Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 
-	// bind the hit handler
-	Mesh->OnComponentHit.AddDynamic(this, &ACombatLavaFloor::OnFloorHit);
+	// create the hazard volume
+	HazardVolume = CreateDefaultSubobject<UBoxComponent>(TEXT("HazardVolume"));
+	HazardVolume->SetupAttachment(Mesh);
+
+	HazardVolume->SetCollisionProfileName(FName("OverlapAllDynamic"));
+	HazardVolume->SetGenerateOverlapEvents(true);
+	HazardVolume->bNavigationRelevant = false;
+
+	// bind the overlap handlers
+	HazardVolume->OnComponentBeginOverlap.AddDynamic(this, &ACombatLavaFloor::OnHazardBeginOverlap);
+	HazardVolume->OnComponentEndOverlap.AddDynamic(this, &ACombatLavaFloor::OnHazardEndOverlap);
+}
+
+void ACombatLavaFloor::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+	UpdateHazardVolume(false);
+}
+
+void ACombatLavaFloor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// floors placed before the hazard volume was added were saved with its default size
+	UpdateHazardVolume(true);
 }
 
-void ACombatLavaFloor::OnFloorHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+void ACombatLavaFloor::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
-	// check if the hit actor is damageable by casting to the interface
-	if (ICombatDamageable* Damageable = Cast<ICombatDamageable>(OtherActor))
+	Super::EndPlay(EndPlayReason);
+
+	// stop damaging our occupants. The subsystem may already be gone during world teardown
+	if (UCombatHazardSubsystem* HazardSubsystem = GetWorld()->GetSubsystem<UCombatHazardSubsystem>())
 	{
-		// damage the actor
-		Damageable->ApplyDamage(Damage, this, Hit.ImpactPoint, FVector::ZeroVector);
+		HazardSubsystem->RemoveHazard(this);
 	}
 }
+
+void ACombatLavaFloor::OnHazardBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	// damage is only dealt by the server. The floor doesn't replicate, so clients also have authority over their copy
+	if (GetNetMode() == NM_Client || !OtherActor)
+	{
+		return;
+	}
+
+	// only track damageable actors
+	if (GetWorld()->GetSubsystem<UCombatDamageableSubsystem>()->FindDamageable(OtherActor))
+	{
+		GetWorld()->GetSubsystem<UCombatHazardSubsystem>()->AddOccupant(this, OtherActor, Damage, DamageInterval);
+	}
+}
+
+void ACombatLavaFloor::OnHazardEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	if (GetNetMode() == NM_Client || !OtherActor)
+	{
+		return;
+	}
+
+	// the actor may still be overlapping through another of its components
+	if (!HazardVolume->IsOverlappingActor(OtherActor))
+	{
+		GetWorld()->GetSubsystem<UCombatHazardSubsystem>()->RemoveOccupant(this, OtherActor);
+	}
+}
+
+void ACombatLavaFloor::UpdateHazardVolume(bool bUpdateOverlaps)
+{
+	const UStaticMesh* StaticMesh = Mesh->GetStaticMesh();
+
+	if (!StaticMesh)
+	{
+		return;
+	}
+
+	// the volume is attached to the mesh, so it works in mesh space and picks up the mesh's scale.
+	// Undo the vertical scale on the extra height so it stays in world units
+	const FBoxSphereBounds MeshBounds = StaticMesh->GetBounds();
+	const float ScaledHeight = HazardHeight / FMath::Max(FMath::Abs(Mesh->GetComponentScale().Z), UE_KINDA_SMALL_NUMBER);
+
+	// cover the whole mesh and extend above its top
+	HazardVolume->SetRelativeLocation(MeshBounds.Origin + FVector(0.0f, 0.0f, ScaledHeight * 0.5f));
+	HazardVolume->SetBoxExtent(MeshBounds.BoxExtent + FVector(0.0f, 0.0f, ScaledHeight * 0.5f), bUpdateOverlaps);
+}
@@ -7,10 +7,12 @@
 #include "CombatLavaFloor.generated.h"
 
 class UStaticMeshComponent;
+class UBoxComponent;
 class UPrimitiveComponent;
 
 /**
- *  A basic actor that applies damage on contact through the ICombatDamageable interface. 
+ *  A basic actor that damages anything standing on it through the ICombatDamageable interface.
+ *  Actors are tracked as they enter and leave the hazard volume, and damaged on a fixed interval by the hazard subsystem
  */
 UCLASS(abstract)
 class ACombatLavaFloor : public AActor
@@ -21,12 +23,24 @@ class ACombatLavaFloor : public AActor
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* Mesh;
 
+	/** Hazard volume. Sized from the mesh bounds to cover the floor and extend HazardHeight above it, so actors standing on the floor overlap it */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components, meta = (AllowPrivateAccess = "true"))
+	UBoxComponent* HazardVolume;
+
 protected:
 
-	/** Amount of damage to deal on contact */
+	/** Amount of damage to deal every damage interval while an actor is inside the hazard */
 	UPROPERTY(EditAnywhere, Category="Damage")
 	float Damage = 10000.0f;
 
+	/** Time between damage ticks while an actor is inside the hazard */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0.05, Units = "s"))
+	float DamageInterval = 0.5f;
+
+	/** How far the hazard volume extends above the top of the floor mesh */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, Units = "cm"))
+	float HazardHeight = 20.0f;
+
 public:	
 
 	/** Constructor */
@@ -34,7 +48,23 @@ public:
 
 protected:
 
-	/** Blocking hit handler */
+	/** Sizes the hazard volume to the mesh */
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	/** Sizes the hazard volume again, for floors saved before it existed */
+	virtual void BeginPlay() override;
+
+	/** Stops damaging the occupants */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Hazard volume begin overlap handler */
+	UFUNCTION()
+	void OnHazardBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	/** Hazard volume end overlap handler */
 	UFUNCTION()
-	void OnFloorHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+	void OnHazardEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	/** Fits the hazard volume to the mesh bounds */
+	void UpdateHazardVolume(bool bUpdateOverlaps);
 };
@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatLifeBarSubsystem.h"
+
+void UCombatLifeBarSubsystem::RegisterLifeBar(const AActor* Actor, const FVector& Offset, const FLinearColor& Color)
+{
+	check(Actor);
+
+	// replace any previous registration for this actor
+	UnregisterLifeBar(Actor);
+
+	FCombatLifeBarEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Offset = Offset;
+	Entry.Color = Color;
+
+	// add the bar and index it by actor
+	LifeBarIndices.Add(Actor, LifeBars.Add(Entry));
+}
+
+void UCombatLifeBarSubsystem::UnregisterLifeBar(const AActor* Actor)
+{
+	int32 LifeBarIndex;
+	if (!LifeBarIndices.RemoveAndCopyValue(Actor, LifeBarIndex))
+	{
+		return;
+	}
+
+	// swap the last bar into the gap to keep the array packed
+	LifeBars.RemoveAtSwap(LifeBarIndex, EAllowShrinking::No);
+
+	// fix up the index of the bar that was moved
+	if (LifeBars.IsValidIndex(LifeBarIndex))
+	{
+		LifeBarIndices.FindChecked(LifeBars[LifeBarIndex].Actor) = LifeBarIndex;
+	}
+}
+
+void UCombatLifeBarSubsystem::SetLifePercentage(const AActor* Actor, float Percent)
+{
+	if (FCombatLifeBarEntry* Entry = FindLifeBar(Actor))
+	{
+		Entry->Percent = FMath::Clamp(Percent, 0.0f, 1.0f);
+	}
+}
+
+void UCombatLifeBarSubsystem::SetBarColor(const AActor* Actor, const FLinearColor& Color)
+{
+	if (FCombatLifeBarEntry* Entry = FindLifeBar(Actor))
+	{
+		Entry->Color = Color;
+	}
+}
+
+void UCombatLifeBarSubsystem::SetLifeBarVisible(const AActor* Actor, bool bVisible)
+{
+	if (FCombatLifeBarEntry* Entry = FindLifeBar(Actor))
+	{
+		Entry->bVisible = bVisible;
+	}
+}
+
+FCombatLifeBarEntry* UCombatLifeBarSubsystem::FindLifeBar(const AActor* Actor)
+{
+	const int32* LifeBarIndex = LifeBarIndices.Find(Actor);
+	return LifeBarIndex ? &LifeBars[*LifeBarIndex] : nullptr;
+}
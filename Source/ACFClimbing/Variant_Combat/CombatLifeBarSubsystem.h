@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatLifeBarSubsystem.generated.h"
+
+/**
+ *  State of a single screen space life bar
+ */
+struct FCombatLifeBarEntry
+{
+	/** Actor the bar floats over. Owners unregister on EndPlay, so this never dangles */
+	const AActor* Actor = nullptr;
+
+	/** Offset from the actor's location, in actor space */
+	FVector Offset = FVector::ZeroVector;
+
+	/** Fill amount in the 0-1 range */
+	float Percent = 1.0f;
+
+	/** Fill color */
+	FLinearColor Color = FLinearColor::Red;
+
+	/** If false, the bar is not drawn */
+	bool bVisible = true;
+};
+
+/**
+ *  Holds the life bars of every combat actor in the world in one compact array.
+ *  Actors push value changes here and the HUD draws all bars in a single pass,
+ *  instead of each actor rendering its own world space widget
+ */
+UCLASS()
+class UCombatLifeBarSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Registered life bars, packed with no gaps */
+	TArray<FCombatLifeBarEntry> LifeBars;
+
+	/** Maps each registered actor to its life bar index */
+	TMap<const AActor*, int32> LifeBarIndices;
+
+public:
+
+	/** Adds a full, visible life bar for the actor */
+	void RegisterLifeBar(const AActor* Actor, const FVector& Offset, const FLinearColor& Color);
+
+	/** Removes the actor's life bar */
+	void UnregisterLifeBar(const AActor* Actor);
+
+	/** Sets the actor's life bar to the provided 0-1 percentage value */
+	void SetLifePercentage(const AActor* Actor, float Percent);
+
+	/** Sets the actor's life bar fill color */
+	void SetBarColor(const AActor* Actor, const FLinearColor& Color);
+
+	/** Shows or hides the actor's life bar */
+	void SetLifeBarVisible(const AActor* Actor, bool bVisible);
+
+	/** Returns every registered life bar */
+	const TArray<FCombatLifeBarEntry>& GetLifeBars() const { return LifeBars; }
+
+protected:
+
+	/** Returns the actor's life bar, or nullptr if it isn't registered */
+	FCombatLifeBarEntry* FindLifeBar(const AActor* Actor);
+};
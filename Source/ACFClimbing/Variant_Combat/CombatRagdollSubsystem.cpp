@@ -0,0 +1,272 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatRagdollSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Ragdolls"), STAT_CombatActiveRagdolls, STATGROUP_CombatRagdolls);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Ragdoll Bodies"), STAT_CombatActiveRagdollBodies, STATGROUP_CombatRagdolls);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Denied Ragdolls"), STAT_CombatDeniedRagdolls, STATGROUP_CombatRagdolls);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Hit Reactions"), STAT_CombatActiveHitReactions, STATGROUP_CombatRagdolls);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Evicted Hit Reactions"), STAT_CombatEvictedHitReactions, STATGROUP_CombatRagdolls);
+
+bool UCombatRagdollSubsystem::StartRagdoll(USkeletalMeshComponent* Mesh)
+{
+	check(Mesh);
+
+	// restart the clock if this mesh is already ragdolling
+	ReleaseRagdoll(Mesh);
+
+	// is the budget full?
+	if (ActiveRagdolls.Num() >= MaxActiveRagdolls)
+	{
+		// find the least visible active ragdoll
+		int32 LowestIndex = INDEX_NONE;
+		float LowestPriority = TNumericLimits<float>::Max();
+
+		for (int32 i = 0; i < ActiveRagdolls.Num(); ++i)
+		{
+			const float Priority = ActiveRagdolls[i].Mesh.IsValid() ? GetRagdollPriority(ActiveRagdolls[i].Mesh.Get()) : -1.0f;
+
+			if (Priority < LowestPriority)
+			{
+				LowestPriority = Priority;
+				LowestIndex = i;
+			}
+		}
+
+		// deny the ragdoll if it's not more visible than any of the active ones
+		if (LowestIndex == INDEX_NONE || GetRagdollPriority(Mesh) <= LowestPriority)
+		{
+			// turn off any hit reaction so the fallback animation plays cleanly
+			EndHitReaction(Mesh);
+
+			INC_DWORD_STAT(STAT_CombatDeniedRagdolls);
+			return false;
+		}
+
+		// freeze the least visible ragdoll to make room
+		if (USkeletalMeshComponent* EvictedMesh = ActiveRagdolls[LowestIndex].Mesh.Get())
+		{
+			FreezeRagdoll(EvictedMesh);
+		}
+
+		ActiveRagdolls.RemoveAtSwap(LowestIndex);
+	}
+
+	// enable full ragdoll physics
+	Mesh->SetSimulatePhysics(true);
+
+	FCombatActiveRagdoll& ActiveRagdoll = ActiveRagdolls.AddDefaulted_GetRef();
+	ActiveRagdoll.Mesh = Mesh;
+	ActiveRagdoll.StartTime = GetWorld()->GetTimeSeconds();
+
+	return true;
+}
+
+void UCombatRagdollSubsystem::ReleaseRagdoll(USkeletalMeshComponent* Mesh)
+{
+	ActiveRagdolls.RemoveAllSwap([Mesh](const FCombatActiveRagdoll& ActiveRagdoll)
+	{
+		return ActiveRagdoll.Mesh.Get() == Mesh;
+	});
+
+	// the caller takes over the simulation, so a hit reaction doesn't need tearing down
+	HitReactions.RemoveAllSwap([Mesh](const FCombatHitReaction& HitReaction)
+	{
+		return HitReaction.Mesh.Get() == Mesh;
+	});
+
+	// frozen ragdolls get their tick back so they animate again
+	if (FrozenRagdolls.RemoveSwap(Mesh) > 0)
+	{
+		Mesh->SetComponentTickEnabled(true);
+	}
+}
+
+bool UCombatRagdollSubsystem::StartHitReaction(USkeletalMeshComponent* Mesh, FName PinnedBone, float BlendWeight, float Duration)
+{
+	check(Mesh);
+
+	// hit reactions never evict death ragdolls
+	if (ActiveRagdolls.Num() >= MaxActiveRagdolls)
+	{
+		return false;
+	}
+
+	FCombatHitReaction* HitReaction = HitReactions.FindByPredicate([Mesh](const FCombatHitReaction& Candidate)
+	{
+		return Candidate.Mesh.Get() == Mesh;
+	});
+
+	if (!HitReaction)
+	{
+		// is the budget full? End the oldest reaction, it's the furthest faded out
+		if (HitReactions.Num() >= MaxHitReactions)
+		{
+			int32 OldestIndex = 0;
+
+			for (int32 i = 1; i < HitReactions.Num(); ++i)
+			{
+				if (HitReactions[i].StartTime < HitReactions[OldestIndex].StartTime)
+				{
+					OldestIndex = i;
+				}
+			}
+
+			if (USkeletalMeshComponent* EvictedMesh = HitReactions[OldestIndex].Mesh.Get())
+			{
+				EndHitReaction(EvictedMesh);
+			}
+
+			HitReactions.RemoveAtSwap(OldestIndex);
+
+			INC_DWORD_STAT(STAT_CombatEvictedHitReactions);
+		}
+
+		HitReaction = &HitReactions.AddDefaulted_GetRef();
+		HitReaction->Mesh = Mesh;
+	}
+
+	HitReaction->StartTime = GetWorld()->GetTimeSeconds();
+	HitReaction->BlendWeight = BlendWeight;
+	HitReaction->Duration = FMath::Max(Duration, UE_KINDA_SMALL_NUMBER);
+
+	// enable partial ragdoll physics, but keep the pinned bone animated
+	Mesh->SetPhysicsBlendWeight(BlendWeight);
+	Mesh->SetBodySimulatePhysics(PinnedBone, false);
+
+	return true;
+}
+
+void UCombatRagdollSubsystem::StopHitReaction(USkeletalMeshComponent* Mesh)
+{
+	const int32 NumRemoved = HitReactions.RemoveAllSwap([Mesh](const FCombatHitReaction& HitReaction)
+	{
+		return HitReaction.Mesh.Get() == Mesh;
+	});
+
+	if (NumRemoved > 0)
+	{
+		EndHitReaction(Mesh);
+	}
+}
+
+void UCombatRagdollSubsystem::Tick(float DeltaTime)
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	int32 ActiveBodies = 0;
+
+	for (int32 i = ActiveRagdolls.Num() - 1; i >= 0; --i)
+	{
+		USkeletalMeshComponent* Mesh = ActiveRagdolls[i].Mesh.Get();
+
+		// drop ragdolls whose mesh is gone or was turned off elsewhere
+		if (!Mesh || !Mesh->IsSimulatingPhysics())
+		{
+			ActiveRagdolls.RemoveAtSwap(i);
+			continue;
+		}
+
+		const float ElapsedTime = CurrentTime - ActiveRagdolls[i].StartTime;
+
+		// freeze ragdolls that have settled or run out of time
+		const bool bHasSettled = ElapsedTime >= MinRagdollTime && Mesh->GetPhysicsLinearVelocity().SizeSquared() <= FMath::Square(SettleSpeed);
+
+		if (bHasSettled || ElapsedTime >= MaxRagdollTime)
+		{
+			FreezeRagdoll(Mesh);
+			ActiveRagdolls.RemoveAtSwap(i);
+			continue;
+		}
+
+		ActiveBodies += Mesh->Bodies.Num();
+	}
+
+	INC_DWORD_STAT_BY(STAT_CombatActiveRagdolls, ActiveRagdolls.Num());
+	INC_DWORD_STAT_BY(STAT_CombatActiveRagdollBodies, ActiveBodies);
+
+	UpdateHitReactions();
+}
+
+TStatId UCombatRagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatRagdollSubsystem, STATGROUP_Tickables);
+}
+
+float UCombatRagdollSubsystem::GetRagdollPriority(const USkeletalMeshComponent* Mesh) const
+{
+	const FVector MeshLocation = Mesh->Bounds.Origin;
+
+	// find the closest player camera
+	float ClosestDistanceSquared = TNumericLimits<float>::Max();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+
+		if (PC && PC->PlayerCameraManager)
+		{
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(MeshLocation, PC->PlayerCameraManager->GetCameraLocation()));
+		}
+	}
+
+	// approximate the screen size as bounds radius over distance
+	return Mesh->Bounds.SphereRadius / FMath::Max(FMath::Sqrt(ClosestDistanceSquared), 1.0f);
+}
+
+void UCombatRagdollSubsystem::FreezeRagdoll(USkeletalMeshComponent* Mesh)
+{
+	// stop the bodies where they are, then take them out of the simulation entirely.
+	// With the mesh tick off, the animation never overwrites the pose and the kinematic bodies stay put
+	Mesh->PutAllRigidBodiesToSleep();
+	Mesh->SetSimulatePhysics(false);
+	Mesh->SetComponentTickEnabled(false);
+
+	// forget frozen ragdolls that were destroyed since, so the list doesn't grow over a long session
+	FrozenRagdolls.RemoveAllSwap([](const TWeakObjectPtr<USkeletalMeshComponent>& FrozenMesh) { return !FrozenMesh.IsValid(); });
+	FrozenRagdolls.AddUnique(Mesh);
+}
+
+void UCombatRagdollSubsystem::EndHitReaction(USkeletalMeshComponent* Mesh) const
+{
+	Mesh->SetSimulatePhysics(false);
+	Mesh->SetPhysicsBlendWeight(0.0f);
+}
+
+void UCombatRagdollSubsystem::UpdateHitReactions()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = HitReactions.Num() - 1; i >= 0; --i)
+	{
+		const FCombatHitReaction& HitReaction = HitReactions[i];
+		USkeletalMeshComponent* Mesh = HitReaction.Mesh.Get();
+
+		// drop reactions whose mesh is gone
+		if (!Mesh)
+		{
+			HitReactions.RemoveAtSwap(i);
+			continue;
+		}
+
+		const float Alpha = (CurrentTime - HitReaction.StartTime) / HitReaction.Duration;
+
+		// end reactions that have faded out
+		if (Alpha >= 1.0f)
+		{
+			EndHitReaction(Mesh);
+			HitReactions.RemoveAtSwap(i);
+			continue;
+		}
+
+		// ease the blend out. Only touch the blend weights so the pinned bone stays animated
+		Mesh->SetAllBodiesPhysicsBlendWeight(HitReaction.BlendWeight * FMath::Square(1.0f - Alpha));
+	}
+
+	INC_DWORD_STAT_BY(STAT_CombatActiveHitReactions, HitReactions.Num());
+}
@@ -0,0 +1,130 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRagdollSubsystem.generated.h"
+
+class USkeletalMeshComponent;
+
+DECLARE_STATS_GROUP(TEXT("CombatRagdolls"), STATGROUP_CombatRagdolls, STATCAT_Advanced);
+
+/**
+ *  A ragdoll currently counting against the budget
+ */
+struct FCombatActiveRagdoll
+{
+	/** Simulating mesh */
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+
+	/** World time the ragdoll started at */
+	float StartTime = 0.0f;
+};
+
+/**
+ *  A partial physics hit reaction blending out over time
+ */
+struct FCombatHitReaction
+{
+	/** Mesh blending in physics */
+	TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+
+	/** World time the reaction started at */
+	float StartTime = 0.0f;
+
+	/** Physics blend weight at the start of the reaction */
+	float BlendWeight = 0.0f;
+
+	/** Time the blend takes to fade out */
+	float Duration = 0.0f;
+};
+
+/**
+ *  Caps the number of simulating combat ragdolls in the world.
+ *  When the budget is full, new ragdolls only start if they're more visible than the least visible active one,
+ *  which is frozen to make room. Ragdolls are put to sleep as soon as they settle, or after a time limit.
+ *  Partial physics hit reactions are budgeted separately: they fade out over a fixed duration and are torn down automatically
+ */
+UCLASS()
+class UCombatRagdollSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Maximum number of simulating ragdolls */
+	int32 MaxActiveRagdolls = 8;
+
+	/** Ragdolls can't be frozen for settling before this much time */
+	float MinRagdollTime = 1.0f;
+
+	/** Ragdolls are frozen after this much time, even if they haven't settled */
+	float MaxRagdollTime = 4.0f;
+
+	/** Ragdolls moving slower than this are considered settled */
+	float SettleSpeed = 20.0f;
+
+	/** Ragdolls counting against the budget */
+	TArray<FCombatActiveRagdoll> ActiveRagdolls;
+
+	/** Ragdolls frozen in their last pose, with their simulation and tick turned off */
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> FrozenRagdolls;
+
+	/** Maximum number of partial physics hit reactions. The oldest reaction is ended to make room for a new one */
+	int32 MaxHitReactions = 6;
+
+	/** Hit reactions currently blending physics */
+	TArray<FCombatHitReaction> HitReactions;
+
+public:
+
+	/**
+	 *  Starts full ragdoll simulation on the mesh if the budget allows it.
+	 *  Returns false if the ragdoll was denied, so the caller can fall back to an animation
+	 */
+	bool StartRagdoll(USkeletalMeshComponent* Mesh);
+
+	/** Removes the mesh and any hit reaction it's playing from the budget, and unfreezes it. Call before turning its simulation off */
+	void ReleaseRagdoll(USkeletalMeshComponent* Mesh);
+
+	/**
+	 *  Blends partial physics into the mesh for a hit reaction, keeping the pinned bone animated.
+	 *  The blend fades out over the duration and the simulation is then turned off. Hitting a reacting mesh restarts its reaction.
+	 *  Returns false if the ragdoll budget is full
+	 */
+	bool StartHitReaction(USkeletalMeshComponent* Mesh, FName PinnedBone, float BlendWeight, float Duration);
+
+	/** Ends the mesh's hit reaction right away and turns its simulation off */
+	void StopHitReaction(USkeletalMeshComponent* Mesh);
+
+	/** Returns the number of ragdolls counting against the budget */
+	int32 GetActiveRagdollCount() const { return ActiveRagdolls.Num(); }
+
+	/** Returns the number of hit reactions blending physics */
+	int32 GetHitReactionCount() const { return HitReactions.Num(); }
+
+	// ~begin FTickableGameObject interface
+
+	/** Freezes settled or expired ragdolls, fades out hit reactions and updates the stats */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the tick stat id */
+	virtual TStatId GetStatId() const override;
+
+	// ~end FTickableGameObject interface
+
+protected:
+
+	/** Returns a visibility score for the mesh, based on its size and distance to the closest player camera */
+	float GetRagdollPriority(const USkeletalMeshComponent* Mesh) const;
+
+	/** Stops simulating the ragdoll's bodies, keeping its pose */
+	void FreezeRagdoll(USkeletalMeshComponent* Mesh);
+
+	/** Turns off a hit reaction's physics */
+	void EndHitReaction(USkeletalMeshComponent* Mesh) const;
+
+	/** Fades out every hit reaction, ending the ones that are done */
+	void UpdateHitReactions();
+};
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+#include "CombatDamageableSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatLagCompensationRewindTest, "ACFClimbing.Combat.LagCompensation.RewoundSwingHitsWhereTheTargetWas", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatLagCompensationRewindTest::RunTest(const FString& Parameters)
+{
+	// the server runs at 60 Hz and samples hitboxes at 30 Hz, like the damageable subsystem
+	constexpr float ServerFrameTime = 1.0f / 60.0f;
+	constexpr float HistorySampleInterval = 1.0f / 30.0f;
+	constexpr int32 NumServerFrames = 60;
+
+	// the target strafes sideways at sprint speed
+	constexpr float TargetSpeed = 600.0f;
+	auto GetTargetLocation = [](float Time) { return FVector(0.0f, TargetSpeed * Time, 90.0f); };
+
+	FCombatDamageableEntry Target;
+	Target.Radius = 35.0f;
+	Target.HalfHeight = 55.0f;
+	Target.Location = GetTargetLocation(0.0f);
+	Target.AddHistorySample(0.0f, Target.Location);
+
+	// simulate the server long enough to wrap the history ring buffer
+	float ServerTime = 0.0f;
+	float TimeSinceSample = 0.0f;
+
+	for (int32 Frame = 0; Frame < NumServerFrames; ++Frame)
+	{
+		ServerTime += ServerFrameTime;
+		TimeSinceSample += ServerFrameTime;
+
+		Target.Location = GetTargetLocation(ServerTime);
+
+		if (TimeSinceSample >= HistorySampleInterval)
+		{
+			TimeSinceSample = FMath::Fmod(TimeSinceSample, HistorySampleInterval);
+			Target.AddHistorySample(ServerTime, Target.Location);
+		}
+	}
+
+	// the attacker swings at the target where their client showed it, stopping just short of its center.
+	// Latencies are deliberately off the sample grid so the history has to interpolate
+	constexpr float SwingRadius = 20.0f;
+	constexpr float SwingReach = 150.0f;
+	constexpr float SwingShortfall = 30.0f;
+	const float Latencies[] = { 0.05f, 0.12f, 0.21f, 0.33f };
+
+	for (const float Latency : Latencies)
+	{
+		const FVector SeenLocation = GetTargetLocation(ServerTime - Latency);
+		const FVector SwingStart = SeenLocation - FVector(SwingReach, 0.0f, 0.0f);
+		const FVector SwingEnd = SeenLocation - FVector(SwingShortfall, 0.0f, 0.0f);
+
+		// the rewound hitbox must be where the attacker saw the target
+		const FVector RewoundLocation = Target.GetLocationAtTime(ServerTime - Latency);
+		TestTrue(FString::Printf(TEXT("Rewound location matches what the attacker saw at %.0f ms"), Latency * 1000.0f), RewoundLocation.Equals(SeenLocation, 1.0f));
+
+		// the swing registers against the rewound hitbox
+		FVector ImpactPoint, ImpactNormal;
+		TestTrue(FString::Printf(TEXT("Rewound swing hits at %.0f ms"), Latency * 1000.0f), Target.TestSweep(SwingStart, SwingEnd, SwingRadius, RewoundLocation, ImpactPoint, ImpactNormal));
+
+		// without rewinding, the target has moved out of the swing once latency covers more than the hit distance
+		const float MissDistance = FVector2D(SwingShortfall, TargetSpeed * Latency).Size();
+
+		if (MissDistance > SwingRadius + Target.Radius)
+		{
+			TestFalse(FString::Printf(TEXT("Unrewound swing misses at %.0f ms"), Latency * 1000.0f), Target.TestSweep(SwingStart, SwingEnd, SwingRadius, Target.Location, ImpactPoint, ImpactNormal));
+		}
+	}
+
+	// the history is full by now, and rewinds past it clamp to the oldest sample instead of extrapolating
+	TestEqual(TEXT("History is full"), Target.HistoryNum, CombatHitboxHistoryLength);
+
+	const FCombatHitboxSample& OldestSample = Target.History[(Target.HistoryHead + 1) % CombatHitboxHistoryLength];
+	TestTrue(TEXT("Rewinds past the history clamp to the oldest sample"), Target.GetLocationAtTime(ServerTime - 10.0f).Equals(OldestSample.Location, 1.0f));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,176 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/HitResult.h"
+#include "CombatEnemy.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/**
+	 *  Forwards to the real allocator, counting the allocations made on the game thread.
+	 *  Other threads keep allocating while a test runs, so they're not counted
+	 */
+	class FCombatCountingMalloc final : public FMalloc
+	{
+	public:
+
+		explicit FCombatCountingMalloc(FMalloc* InInnerMalloc)
+			: InnerMalloc(InInnerMalloc)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// growing or creating a block counts, shrinking to nothing is a free
+			if (Count > 0)
+			{
+				CountAllocation();
+			}
+
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			InnerMalloc->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return InnerMalloc->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return InnerMalloc->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return InnerMalloc->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return TEXT("CombatCountingMalloc");
+		}
+
+		/** Returns the number of game thread allocations so far */
+		int32 GetNumAllocations() const { return NumAllocations; }
+
+	private:
+
+		void CountAllocation()
+		{
+			if (IsInGameThread())
+			{
+				++NumAllocations;
+			}
+		}
+
+		/** Allocator doing the actual work */
+		FMalloc* InnerMalloc;
+
+		/** Only written from the game thread */
+		int32 NumAllocations = 0;
+	};
+
+	/**
+	 *  Routes every allocation through a counting allocator while in scope.
+	 *  Blocks allocated inside the scope can be freed after it, since the counting allocator never owns memory
+	 */
+	class FCombatScopedAllocationCounter
+	{
+	public:
+
+		FCombatScopedAllocationCounter()
+			: CountingMalloc(GMalloc)
+			, PreviousMalloc(GMalloc)
+		{
+			GMalloc = &CountingMalloc;
+		}
+
+		~FCombatScopedAllocationCounter()
+		{
+			GMalloc = PreviousMalloc;
+		}
+
+		/** Returns the number of game thread allocations made in scope so far */
+		int32 GetNumAllocations() const { return CountingMalloc.GetNumAllocations(); }
+
+	private:
+
+		FCombatCountingMalloc CountingMalloc;
+		FMalloc* PreviousMalloc;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatEnemyCompletionAllocationTest, "ACFClimbing.Combat.AI.AttackAndLandingCompletionDoNotAllocate", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCombatEnemyCompletionAllocationTest::RunTest(const FString& Parameters)
+{
+	// spawn a bare enemy in a throwaway world. It has no anim instance, so attacks end as soon as we end them
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	ACombatEnemy* Enemy = World->SpawnActor<ACombatEnemy>();
+
+	if (TestNotNull(TEXT("Enemy spawned"), Enemy))
+	{
+		const FHitResult LandingHit;
+
+		// run one attack and landing first, so anything created lazily on first use is out of the way
+		Enemy->DoAIComboAttack();
+		Enemy->AttackMontageEnded(nullptr, false);
+		Enemy->Landed(LandingHit);
+
+		constexpr int32 NumAttacks = 100;
+		int32 NumAttacksCompleted = 0;
+		int32 NumLandings = 0;
+		int32 NumAllocations = 0;
+
+		{
+			FCombatScopedAllocationCounter AllocationCounter;
+
+			for (int32 i = 0; i < NumAttacks; ++i)
+			{
+				// what the combo and charged attack tasks do: note the count on enter, attack, and check the count on tick
+				const uint32 AttackStartCount = Enemy->GetAttackCompletedCount();
+				Enemy->DoAIComboAttack();
+				Enemy->AttackMontageEnded(nullptr, false);
+				NumAttacksCompleted += Enemy->GetAttackCompletedCount() != AttackStartCount ? 1 : 0;
+
+				// what the wait for landing task does
+				const uint32 LandingStartCount = Enemy->GetLandedCount();
+				Enemy->Landed(LandingHit);
+				NumLandings += Enemy->GetLandedCount() != LandingStartCount ? 1 : 0;
+			}
+
+			NumAllocations = AllocationCounter.GetNumAllocations();
+		}
+
+		TestEqual(TEXT("Every attack was seen completing"), NumAttacksCompleted, NumAttacks);
+		TestEqual(TEXT("Every landing was seen"), NumLandings, NumAttacks);
+		TestEqual(TEXT("Allocations while attacking and landing"), NumAllocations, 0);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
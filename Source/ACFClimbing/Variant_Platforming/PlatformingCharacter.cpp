@@ -12,6 +12,7 @@
 #include "EnhancedInputComponent.h"
 #include "TimerManager.h"
 #include "Engine/LocalPlayer.h"
+#include "ACFObstacleProbeComponent.h"
 
 APlatformingCharacter::APlatformingCharacter()
 {
@@ -75,6 +76,11 @@ APlatformingCharacter::APlatformingCharacter()
 	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
 	FollowCamera->bUsePawnControlRotation = false;
+
+	// create the obstacle probe. Wall jumps use a small sphere sweep against the visibility channel
+	ObstacleProbe = CreateDefaultSubobject<UACFObstacleProbeComponent>(TEXT("ObstacleProbe"));
+	ObstacleProbe->ProbeChannel = ECC_Visibility;
+	ObstacleProbe->WallProbeRadius = WallJumpTraceRadius;
 }
 
 void APlatformingCharacter::Move(const FInputActionValue& Value)
@@ -113,27 +119,20 @@ void APlatformingCharacter::MultiJump()
 		// have we already wall jumped?
 		if (!bHasWallJumped)
 		{
-			// run a sphere sweep to check if we're in front of a wall
-			FHitResult OutHit;
-
-			const FVector TraceStart = GetActorLocation();
-			const FVector TraceEnd = TraceStart + (GetActorForwardVector() * WallJumpTraceDistance);
-			const FCollisionShape TraceShape = FCollisionShape::MakeSphere(WallJumpTraceRadius);
+			// check the shared obstacle probe to see if we're in front of a wall
+			const FACFObstacleProfile& Obstacle = ObstacleProbe->GetObstacleProfile(GetActorForwardVector(), GetActorUpVector(), EACFObstacleProbeLayer::Wall);
 
-			FCollisionQueryParams QueryParams;
-			QueryParams.AddIgnoredActor(this);
-
-			if (GetWorld()->SweepSingleByChannel(OutHit, TraceStart, TraceEnd, FQuat(), ECollisionChannel::ECC_Visibility, TraceShape, QueryParams))
+			if (Obstacle.HasWallWithin(WallJumpTraceDistance))
 			{
 				// rotate the character to face away from the wall, so we're correctly oriented for the next wall jump
-				FRotator WallOrientation = OutHit.ImpactNormal.ToOrientationRotator();
+				FRotator WallOrientation = Obstacle.WallNormal.ToOrientationRotator();
 				WallOrientation.Pitch = 0.0f;
 				WallOrientation.Roll = 0.0f;
 
 				SetActorRotation(WallOrientation);
 
 				// apply a launch impulse to the character to perform the actual wall jump
-				const FVector WallJumpImpulse = (OutHit.ImpactNormal * WallJumpBounceImpulse) + (FVector::UpVector * WallJumpVerticalImpulse);
+				const FVector WallJumpImpulse = (Obstacle.WallNormal * WallJumpBounceImpulse) + (FVector::UpVector * WallJumpVerticalImpulse);
 
 				LaunchCharacter(WallJumpImpulse, true, true);
 
@@ -295,6 +294,14 @@ bool APlatformingCharacter::HasWallJumped() const
 	return bHasWallJumped;
 }
 
+void APlatformingCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the probe runs the wall jump sweep, so it takes the radius set on this character or its Blueprint
+	ObstacleProbe->WallProbeRadius = WallJumpTraceRadius;
+}
+
 void APlatformingCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
@@ -10,6 +10,7 @@
 
 class USpringArmComponent;
 class UCameraComponent;
+class UACFObstacleProbeComponent;
 class UInputAction;
 struct FInputActionValue;
 class UAnimMontage;
@@ -34,6 +35,10 @@ class APlatformingCharacter : public ACharacter
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* FollowCamera;
+
+	/** Shared forward obstacle probe, used for wall jump checks */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components, meta = (AllowPrivateAccess = "true"))
+	UACFObstacleProbeComponent* ObstacleProbe;
 	
 protected:
 
@@ -127,6 +132,9 @@ public:
 
 public:	
 	
+	/** Passes the wall jump settings on to the obstacle probe */
+	virtual void PostInitializeComponents() override;
+
 	/** EndPlay cleanup */
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
@@ -154,7 +162,7 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Wall Jump")
 	float WallJumpTraceDistance = 50.0f;
 
-	/** Radius of the wall jump sphere trace check */
+	/** Radius of the wall jump sphere trace check. Passed on to the obstacle probe's wall probe radius */
 	UPROPERTY(EditAnywhere, Category="Wall Jump")
 	float WallJumpTraceRadius = 25.0f;
 
@@ -181,4 +189,7 @@ public:
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
+	/** Returns ObstacleProbe subobject **/
+	FORCEINLINE class UACFObstacleProbeComponent* GetObstacleProbe() const { return ObstacleProbe; }
+
 };
@@ -5,20 +5,22 @@
 #include "StateTreeExecutionContext.h"
 #include "StateTreeExecutionTypes.h"
 #include "AIController.h"
-#include "Kismet/GameplayStatics.h"
+#include "ACFPlayerInfoSubsystem.h"
 
 EStateTreeRunStatus FStateTreeGetPlayerTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
 {
 	// get the instance data
 	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-	// set the player pawn as the target
-	InstanceData.TargetPlayer = UGameplayStatics::GetPlayerPawn(InstanceData.Controller.Get(), 0);
-
-	// are the NPC and target valid?
-	if (IsValid(InstanceData.TargetPlayer) && IsValid(InstanceData.NPC))
+	// is the NPC valid?
+	if (IsValid(InstanceData.NPC))
 	{
-		InstanceData.bValidTarget = FVector::Distance(InstanceData.NPC->GetActorLocation(), InstanceData.TargetPlayer->GetActorLocation()) < InstanceData.RangeMax;
+		// set the closest player from this frame's shared player snapshot as the target
+		float DistanceToPlayer = 0.0f;
+		const FACFPlayerSnapshot* Player = InstanceData.NPC->GetWorld()->GetSubsystem<UACFPlayerInfoSubsystem>()->FindNearestPlayer(InstanceData.NPC->GetActorLocation(), DistanceToPlayer);
+
+		InstanceData.TargetPlayer = Player ? Player->Pawn : nullptr;
+		InstanceData.bValidTarget = Player && DistanceToPlayer < InstanceData.RangeMax;
 	}
 
 	return EStateTreeRunStatus::Running;
@@ -13,6 +13,7 @@
 #include "SideScrollingInteractable.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "TimerManager.h"
+#include "ACFObstacleProbeComponent.h"
 
 ASideScrollingCharacter::ASideScrollingCharacter()
 {
@@ -57,6 +58,11 @@ ASideScrollingCharacter::ASideScrollingCharacter()
 
 	// enable double jump
 	JumpMaxCount = 2;
+
+	// create the obstacle probe. Wall jumps use a line trace against the visibility channel
+	ObstacleProbe = CreateDefaultSubobject<UACFObstacleProbeComponent>(TEXT("ObstacleProbe"));
+	ObstacleProbe->ProbeChannel = ECC_Visibility;
+	ObstacleProbe->WallProbeRadius = 0.0f;
 }
 
 void ASideScrollingCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -225,25 +231,18 @@ void ASideScrollingCharacter::MultiJump()
 	// if we have a horizontal input, try for wall jump first
 	if (!bHasWallJumped && !FMath::IsNearlyZero(ActionValueY))
 	{
-		// trace ahead of the character for walls
-		FHitResult OutHit;
-
-		const FVector Start = GetActorLocation();
-		const FVector End = Start + (FVector(ActionValueY > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f) * WallJumpTraceDistance);
-
-		FCollisionQueryParams QueryParams;
-		QueryParams.AddIgnoredActor(this);
-
-		GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
+		// check the shared obstacle probe for walls ahead of the character
+		const FVector WallDirection = FVector(ActionValueY > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f);
+		const FACFObstacleProfile& Obstacle = ObstacleProbe->GetObstacleProfile(WallDirection, FVector::UpVector, EACFObstacleProbeLayer::Wall);
 
-		if (OutHit.bBlockingHit)
+		if (Obstacle.HasWallWithin(WallJumpTraceDistance))
 		{
 			// rotate to the bounce direction
-			const FRotator BounceRot = UKismetMathLibrary::MakeRotFromX(OutHit.ImpactNormal);
+			const FRotator BounceRot = UKismetMathLibrary::MakeRotFromX(Obstacle.WallNormal);
 			SetActorRotation(FRotator(0.0f, BounceRot.Yaw, 0.0f));
 
 			// calculate the impulse vector
-			FVector WallJumpImpulse = OutHit.ImpactNormal * WallJumpHorizontalImpulse;
+			FVector WallJumpImpulse = Obstacle.WallNormal * WallJumpHorizontalImpulse;
 			WallJumpImpulse.Z = GetCharacterMovement()->JumpZVelocity * WallJumpVerticalMultiplier;
 
 			// launch the character away from the wall
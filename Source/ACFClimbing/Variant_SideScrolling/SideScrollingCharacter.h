@@ -7,6 +7,7 @@
 #include "SideScrollingCharacter.generated.h"
 
 class UCameraComponent;
+class UACFObstacleProbeComponent;
 class UInputAction;
 struct FInputActionValue;
 
@@ -22,6 +23,10 @@ class ASideScrollingCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Camera", meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* Camera;
 
+	/** Shared forward obstacle probe, used for wall jump checks */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Components", meta = (AllowPrivateAccess = "true"))
+	UACFObstacleProbeComponent* ObstacleProbe;
+
 protected:
 
 	/** Move Input Action */